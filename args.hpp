@@ -9,27 +9,374 @@
  * Strong exception safety guarantee: if any member throws an exception,
  * the object is guaranteed to be left untouched.
  *
- * This header also contains one helper class, range_parser.
+ * The strings themselves are not copied into the argument vector;
+ * it stores views into either the caller's argv (see cmdline::borrow_argv)
+ * or strings owned by the argument vector.
+ * Copies, subargument and subcommand vectors are slices
+ * that share the storage of the original vector;
+ * the storage is only copied when push_back is called on a slice.
+ *
+ * All that storage is allocated from a std::pmr::memory_resource,
+ * so that a whole tree of argument vectors can live in a single arena.
+ *
+ * This header also contains the helpers used with args,
+ * such as parsers with range checks, diagnostics sinks,
+ * cursors and snapshots over the arguments and predicates for them;
+ * each is documented where it is declared.
+ *
+ * Requires C++17.
  */
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <ostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <variant>
 #include <vector>
 
+#if __cplusplus >= 202002L
+#include <ranges>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CMDLINE_SSE2 1
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CMDLINE_POSIX 1
+#else
+#include <filesystem>
+#endif
+
 namespace cmdline {
 
     class args;
-    class range_parser;
+    template< typename Min, typename Max > class range_parser;
+    template< auto Min, auto Max > class static_range_parser;
+    class subcmd_list;
+    class args_snapshot;
+    class arg_cursor;
+    class arg_range;
+
+    /* Tag type to select the non-owning args constructor.
+     * See args::args( int, char const * const *, borrow_argv_t ).
+     */
+    struct borrow_argv_t {
+        explicit borrow_argv_t() = default;
+    };
+    inline constexpr borrow_argv_t borrow_argv{};
+
+    /* Tag type to select the multithreaded args::extract.
+     * See args::extract( std::size_t, parallel_t, unsigned ).
+     */
+    struct parallel_t {
+        explicit parallel_t() = default;
+    };
+    inline constexpr parallel_t parallel{};
+
+    /* Reasons for the failure of the non-throwing members of args
+     * (try_peek, try_next, try_subarg, ...).
+     */
+    enum class error_code {
+        none,
+        no_arguments_left,      // There is no next argument.
+        vector_too_short,       // A positive index points past the end.
+        negative_index,         // A negative index points before the beginning.
+        not_enough_arguments,   // Too few arguments to form a subarg/subcmd.
+    };
+
+    /* Returns a human-readable description of the error code.
+     */
+    const char * message( error_code );
+
+    /* Either a value of type T or the error_code explaining its absence.
+     * Returned by the non-throwing members of args.
+     *
+     * Use like this:
+     *  while( auto arg = args.try_next() )
+     *      process( *arg );
+     */
+    template< typename T >
+    class result {
+        T _value;
+        error_code _error;
+    public:
+        result( T value ) :
+            _value( std::move(value) ),
+            _error( error_code::none )
+        {}
+        result( error_code error ) :
+            _value(),
+            _error( error )
+        {}
+
+        bool has_value() const { return _error == error_code::none; }
+        explicit operator bool() const { return has_value(); }
+        error_code error() const { return _error; }
+
+        /* Access the value without checking. */
+        T & operator*() { return _value; }
+        const T & operator*() const { return _value; }
+        T * operator->() { return &_value; }
+        const T * operator->() const { return &_value; }
+
+        /* Access the value; throws std::out_of_range if there is none. */
+        T & value() {
+            if( !has_value() )
+                throw std::out_of_range( message( _error ) );
+            return _value;
+        }
+        const T & value() const {
+            if( !has_value() )
+                throw std::out_of_range( message( _error ) );
+            return _value;
+        }
+    };
+
+    /* Kinds of problems with the arguments; see cmdline::diagnostic. */
+    enum class diagnostic_kind : unsigned char {
+        could_not_parse,            // 'text' is not a valid value.
+        partially_parsed,           // Only part of 'text' was used; 'context' is the rest.
+        below_minimum,              // 'text' is smaller than 'bound';
+                                    // 'context' is the option name, if known.
+        above_maximum,              // 'text' is greater than 'bound'; same as above.
+        extract_failed,             // 'count' of the 'total' values of args::extract
+                                    // failed; the next 'count' diagnostics say why.
+        recursive_response_file,    // Response file 'text' includes itself.
+        unterminated_quote,         // Response file 'text' has an unterminated quote.
+        unknown_option,             // 'text' is not a known option.
+        missing_option_argument,    // Option 'text' requires 'count' arguments.
+    };
+
+    /* A problem with the arguments, as reported by args::report.
+     *
+     * 'index' is the position of the offending argument
+     * in the argument vector that reported it (0 is the first argument
+     * after the program name), or no_index if there is no such argument.
+     *
+     * The string views point to storage owned by whoever holds the diagnostic;
+     * for diagnostics in a cmdline::diagnostics, that is the sink itself.
+     */
+    struct diagnostic {
+        using bound_type = std::variant<
+            std::monostate,
+            long long,
+            unsigned long long,
+            long double,
+            std::string_view    // Bounds of any other type, already formatted,
+                                // and those of static_range_parser.
+        >;
+
+        static constexpr std::size_t no_index = -1;
+
+        diagnostic_kind kind;
+        std::size_t index;
+        std::string_view text;
+        std::string_view context;
+        bound_type bound;
+        std::size_t count = 0;
+        std::size_t total = 0;
+
+        explicit diagnostic(
+            diagnostic_kind kind,
+            std::size_t index = no_index,
+            std::string_view text = std::string_view()
+        ) :
+            kind( kind ),
+            index( index ),
+            text( text )
+        {}
+    };
+
+    /* Writes the message of the diagnostic, exactly as args would write it
+     * to log(); for instance, "Error: could not parse 0.3x.\n".
+     */
+    std::ostream & operator<<( std::ostream &, const diagnostic & );
+
+    /* Diagnostics sink: records the problems found while parsing an args,
+     * so that they are only formatted if and when the caller wants to.
+     * See args::diagnostics.
+     *
+     * The strings of each diagnostic are copied into a few large chunks
+     * owned by the sink, so recording a diagnostic is cheap
+     * and the views stay valid until clear() or destruction,
+     * even if the argument vector is gone.
+     *
+     * All that memory is allocated from a std::pmr::memory_resource,
+     * like the memory of args.
+     */
+    class diagnostics {
+        std::pmr::vector< diagnostic > _entries;
+        /* Each chunk is reserved up front and never grows past its capacity,
+         * and std::deque never relocates its elements,
+         * so the views into the chunks stay valid. */
+        std::pmr::deque< std::pmr::string > _chunks;
+
+        static constexpr std::size_t chunk_size = 4096;
+
+    public:
+        explicit diagnostics(
+            std::pmr::memory_resource * resource = std::pmr::get_default_resource()
+        );
+
+        /* The copy uses the memory resource of 'other'.
+         * Assignment keeps the memory resource of the target. */
+        diagnostics( const diagnostics & other );
+        diagnostics( diagnostics && other ) = default;
+        diagnostics & operator=( const diagnostics & other );
+        diagnostics & operator=( diagnostics && other );
+
+        std::pmr::memory_resource * resource() const;
+
+        using const_iterator = std::pmr::vector< diagnostic >::const_iterator;
+
+        std::size_t size() const;
+        bool empty() const;
+        const diagnostic & operator[]( std::size_t ) const;
+        const_iterator begin() const;
+        const_iterator end() const;
+
+        /* Records a copy of the diagnostic. */
+        void push_back( const diagnostic & );
+
+        /* Records copies of all diagnostics of 'other', in order. */
+        void append( const diagnostics & other );
+
+        void clear();
+
+        /* Writes every message, as args would have written them to log().
+         * The failures after an extract_failed diagnostic are written
+         * as a single report:
+         *  Error: 2 of 1000 values could not be parsed:
+         *    value 17: could not parse 0.3x.
+         *    value 512: partially parsed string; unparsed bit: 'e'
+         */
+        void format( std::ostream & ) const;
+
+        /* Same as format, but returns the text. */
+        std::string str() const;
+
+    private:
+        std::string_view store( std::string_view );
+    };
 
     class args {
-        std::vector< std::string > _args;
-        std::string _program_name;
+        /* Storage shared between an argument vector and its slices.
+         *
+         * Every view points either to the caller's argv,
+         * to an element of 'strings' or to some ancestor's strings.
+         * std::deque never relocates its elements on push_back,
+         * so the views stay valid as long as the backing is alive.
+         *
+         * 'resources' keeps alive other memory the views point to,
+         * like memory-mapped response files.
+         *
+         * A backing is only modified while it is not shared.
+         * It is allocated from, and allocates from, args::_resource.
+         *
+         * Only strings[0] to strings[used-1] are in use;
+         * the others are kept so that args::assign can reuse their capacity.
+         *
+         * 'adopted' holds the std::strings moved into args::push_back,
+         * so that their buffers can be used without copying.
+         */
+        struct backing {
+            std::pmr::vector< std::string_view > views;
+            std::pmr::deque< std::pmr::string > strings;
+            std::size_t used;
+            std::pmr::deque< std::string > adopted;
+            std::shared_ptr< const backing > parent;
+            std::pmr::vector< std::shared_ptr< const void > > resources;
+
+            explicit backing( std::pmr::memory_resource * resource ) :
+                views( resource ),
+                strings( resource ),
+                used( 0 ),
+                adopted( resource ),
+                resources( resource )
+            {}
+
+            /* Returns an empty string, reusing an unused one if possible. */
+            std::pmr::string & new_string() {
+                if( used == strings.size() )
+                    strings.emplace_back();
+                std::pmr::string & ret = strings[used++];
+                ret.clear();
+                return ret;
+            }
+
+            /* Makes room for 'count' more views, growing geometrically. */
+            void reserve_views( std::size_t count ) {
+                if( views.size() + count > views.capacity() )
+                    views.reserve( std::max( views.size() + count, 2 * views.capacity() ) );
+            }
+
+            /* Returns a copy of 'str' stored in this backing. */
+            std::string_view store( std::string_view str ) {
+                return new_string().assign( str );
+            }
+
+            /* Whether 'p' may point into memory that clear() recycles
+             * or releases; conservative if there are ancestors or files. */
+            bool may_own( const char * p ) const {
+                if( parent || !resources.empty() )
+                    return true;
+                std::less_equal< const char * > le;
+                auto in = [&]( const auto & str ) {
+                    return le( str.data(), p ) && le( p, str.data() + str.size() );
+                };
+                for( std::size_t i = 0; i < used; i++ )
+                    if( in( strings[i] ) )
+                        return true;
+                for( const std::string & str : adopted )
+                    if( in( str ) )
+                        return true;
+                return false;
+            }
+
+            /* Forgets everything, but keeps the allocated memory. */
+            void clear() {
+                views.clear();
+                used = 0;
+                adopted.clear();
+                parent.reset();
+                resources.clear();
+            }
+        };
+
+        /* This object sees the range [_begin, _end) of _backing->views;
+         * _index is the absolute position of the next argument. */
+        std::shared_ptr< backing > _backing;
+        std::size_t _begin;
+        std::size_t _end;
         std::size_t _index;
+        std::string _program_name;
+        std::pmr::memory_resource * _resource;
 
         std::ostream * _log;
+        cmdline::diagnostics * _diagnostics;
 
     public:
         /* Constructs the argument vector from the given argc and argv.
@@ -40,14 +387,105 @@ namespace cmdline {
          * argv[0] is stored as the program_name.
          *
          * By default, the logging device is std::cerr.
+         *
+         * The arguments are copied into a single buffer,
+         * so argv may be destroyed after the constructor returns.
+         *
+         * All the memory used by this object, by its copies
+         * and by the argument vectors derived from it
+         * (except for program_name) is allocated from 'resource',
+         * and so are the diagnostics of failed extractions.
+         * A sink set with diagnostics() allocates from its own resource.
+         * For instance, to parse a command with no heap allocation:
+         *  std::pmr::monotonic_buffer_resource arena( buffer, size );
+         *  cmdline::args args( argc, argv, &arena );
+         *  cmdline::diagnostics sink( &arena );
+         *  args.diagnostics( &sink );
+         * The resource must outlive all these objects.
+         */
+        args(
+            int argc,
+            char const * const * argv,
+            std::pmr::memory_resource * resource = std::pmr::get_default_resource()
+        );
+
+        /* Same as above, but the arguments are not copied at all:
+         * the argument vector will hold views into argv.
+         * This means no allocation besides the vector itself,
+         * but argv[1] to argv[argc-1] must outlive this object
+         * and every argument vector derived from it.
+         * (The argv received by main satisfies this requirement.)
+         *
+         * Use like this:
+         *  cmdline::args args( argc, argv, cmdline::borrow_argv );
+         */
+        args(
+            int argc,
+            char const * const * argv,
+            borrow_argv_t,
+            std::pmr::memory_resource * resource = std::pmr::get_default_resource()
+        );
+
+        /* Constructs the argument vector by splitting a command line,
+         * following the quoting rules of bash (without any expansion);
+         * see expand_response_files for the exact rules.
+         *
+         * Every word becomes an argument; program_name will be empty.
+         * The line is copied, so it may be destroyed afterwards.
+         *
+         * Throws std::invalid_argument if the line ends
+         * inside quotes or right after a backslash.
          */
-        args( int argc, char const * const * argv );
+        explicit args(
+            std::string_view command_line,
+            std::pmr::memory_resource * resource = std::pmr::get_default_resource()
+        );
 
         /* Constructs an empty argument vector.
          * You need to use the args::push_back method to populate this object,
          * and args::program_name to configure its name.
          */
         args();
+        explicit args( std::pmr::memory_resource * resource );
+
+        /* Copies are O(1) slices sharing the storage (see above).
+         * A moved-from object is empty, but keeps its resource and log.
+         */
+        args( const args & ) = default;
+        args( args && ) noexcept;
+        args & operator=( const args & ) = default;
+        args & operator=( args && ) noexcept;
+
+        /* Replaces the contents of this object,
+         * as if it were constructed with the same arguments,
+         * but keeping the memory resource and the log.
+         *
+         * If no copy or slice of this object is alive,
+         * the memory already allocated is reused,
+         * so that parsing one command after another
+         * (see also args_pool below) eventually needs no allocation.
+         *
+         * The arguments may point into this object itself,
+         * as in args.assign( args.peek_view() ) to re-split an argument;
+         * they are then copied before the memory is reused
+         * (even with borrow_argv).
+         *
+         * Reusing the memory invalidates the views returned earlier
+         * by peek_view, next_view and the like, and all the iterators,
+         * unless a copy or slice of this object keeps the old storage alive.
+         *
+         * These members offer only the basic exception safety guarantee:
+         * if they throw, the object is left valid, but empty.
+         */
+        void assign( int argc, char const * const * argv );
+        void assign( int argc, char const * const * argv, borrow_argv_t );
+        void assign( std::string_view command_line );
+
+        /* Removes all the arguments and the program_name,
+         * keeping the memory for reuse like assign;
+         * the same views and iterators are invalidated.
+         */
+        void clear();
 
 
         /* Returns the number of remaining strings in the argument vector.
@@ -75,6 +513,18 @@ namespace cmdline {
          */
         std::string peek( int index ) const;
 
+        /* Same as the above, but return a view into the argument vector
+         * instead of a copy of the argument.
+         *
+         * The view stays valid as long as this object,
+         * or any argument vector copied or derived from it, exists,
+         * and until assign or clear is called on this object
+         * while it is the only one using its storage
+         * (the memory is then reused for the new arguments).
+         */
+        std::string_view peek_view() const;
+        std::string_view peek_view( int index ) const;
+
         /* Shifts the argument vector by one position.
          *
          * If there is no strings left, throws std::out_of_range.
@@ -88,9 +538,48 @@ namespace cmdline {
          */
         std::string next();
 
+        /* Same as next(), but returns a view instead of a copy.
+         * The same lifetime rules as for peek_view() apply.
+         */
+        std::string_view next_view();
+
+        /* Non-throwing versions of peek_view, shift and next_view.
+         * Instead of throwing std::out_of_range,
+         * they return the corresponding error_code
+         * and leave the argument vector untouched.
+         *
+         * try_shift returns error_code::none on success.
+         */
+        result< std::string_view > try_peek() const;
+        result< std::string_view > try_peek( int index ) const;
+        error_code try_shift();
+        result< std::string_view > try_next();
+
         /* Appends the given string to the argument vector.
+         *
+         * The first overload copies the string into memory
+         * allocated from resource().
+         * The second one takes ownership of the string,
+         * so its buffer is used as is.
          */
-        void push_back( std::string );
+        void push_back( const std::string & );
+        void push_back( std::string && );
+
+        /* Appends a copy of the given string to the argument vector,
+         * without constructing a std::string first.
+         */
+        void emplace_back( std::string_view );
+
+        /* Appends copies of every string in the range
+         * (anything convertible to std::string_view)
+         * to the argument vector.
+         *
+         * The range is traversed twice, to size the storage:
+         * appending n strings takes at most two allocations,
+         * one for the views and one for a buffer with all the characters.
+         */
+        template< typename Range >
+        void append( const Range & range );
 
         /* Retrurns a range parser to parse the next command line option.
          *
@@ -100,15 +589,77 @@ namespace cmdline {
          *  if( args.next() == "--val" )
          *      args.range( 2, 14 ) >> i;
          *
-         * If i is not between 2 and 14, an error will be written to log().
+         * If i is not between 2 and 14, an error will be reported (see report).
          * The other overload merely specifies the minimum value.
          *
          * Observation: the error message is based on the previous argument.
          * If you are scanning several different arguments,
          * use operator>> directly and supply your own error messages.
+         *
+         * The bounds keep their own types and are compared exactly
+         * against the parsed number; for instance,
+         *  args.range( -1, 1ull << 60 ) >> id;
+         * behaves as expected for an unsigned long long 'id'.
+         */
+        template< typename Min >
+        cmdline::range_parser< Min, Min > range( Min min );
+        template< typename Min, typename Max >
+        cmdline::range_parser< Min, Max > range( Min min, Max max );
+
+        /* Same as range( Min, Max ), but the bounds are template arguments:
+         *  args.range< 2, 14 >() >> i;
+         *
+         * The bounds must be integers.
+         * Their text in the error messages is built at compile time,
+         * and checks that cannot fail for the type of the number are omitted;
+         * for instance, range< 0, 65535 >() >> an_unsigned_short
+         * performs no comparisons at all.
+         */
+        template< auto Min, auto Max = Min >
+        cmdline::static_range_parser< Min, Max > range();
+
+        /* Parses the next 'count' arguments as values of type T
+         * and consumes them, as if by 'count' calls to operator>>.
+         * For arithmetic types, the values are parsed in place,
+         * without copying the arguments.
+         *
+         * Instead of one message per bad value,
+         * all failures are reported at once (see report), as in:
+         *  Error: 2 of 1000 values could not be parsed:
+         *    value 17: could not parse 0.3x.
+         *    value 512: partially parsed string; unparsed bit: 'e'
+         * where the values are numbered from zero.
+         *
+         * If there isn't enough arguments left, throws std::out_of_range
+         * and nothing is consumed.
+         */
+        template< typename T >
+        std::vector< T > extract( std::size_t count );
+
+        /* Same as above, but writes the values to out[0], ..., out[count-1]. */
+        template< typename T >
+        void extract( T * out, std::size_t count );
+
+        /* Same as extract, but the arguments are split among 'threads'
+         * threads (std::thread::hardware_concurrency() if zero):
+         *  auto weights = args.extract< double >( n, cmdline::parallel );
+         *
+         * The values and the report are exactly the same as extract's,
+         * in the same order. The report is made by the calling thread,
+         * after the others finish.
+         * Counts too small to be worth a thread are parsed sequentially.
+         */
+        template< typename T >
+        std::vector< T > extract( std::size_t count, parallel_t, unsigned threads = 0 );
+        template< typename T >
+        void extract( T * out, std::size_t count, parallel_t, unsigned threads = 0 );
+
+        /* Parses and consumes all arguments up to (but not including)
+         * the first one for which the predicate is true.
+         * The predicates are the same as subarg_until's.
          */
-        cmdline::range_parser range( double min );
-        cmdline::range_parser range( double min, double max );
+        template< typename T, typename Predicate >
+        std::vector< T > extract_until( Predicate && predicate );
 
         /* Constructs a "subargument" vector from the current position.
          * The following 'size' arguments will be used as argument vectors.
@@ -134,6 +685,19 @@ namespace cmdline {
          */
         args subarg_until( bool (* predicate )(const std::string&) );
 
+        /* Same as above, but accepts any callable object,
+         * including capturing lambdas and the predicates defined below
+         * (cmdline::equals, cmdline::starts_with and cmdline::one_of).
+         *
+         * If the predicate can be called with a std::string_view,
+         * the arguments are not copied.
+         * cmdline::equals and cmdline::one_of are not called at all;
+         * instead, the arguments are filtered by length and first byte
+         * before being compared against the tokens.
+         */
+        template< typename Predicate >
+        args subarg_until( Predicate && predicate );
+
         /* Same as subarg, but args::peek() will be used as program_name
          * for the returned argument vector.
          * args::peek() itself will not appear in the returned vector.
@@ -149,19 +713,420 @@ namespace cmdline {
          */
         args subcmd_until( bool (* predicate )(const std::string&) );
 
+        template< typename Predicate >
+        args subcmd_until( Predicate && predicate );
+
+        /* Non-throwing versions of subarg and subcmd.
+         * On failure, returns error_code::not_enough_arguments
+         * (or error_code::no_arguments_left if try_subcmd could not find
+         * the program name) and does not advance the argument vector.
+         */
+        result< args > try_subarg( std::size_t size );
+        result< args > try_subcmd( std::size_t size );
+
+        /* Splits all the remaining arguments into subcommands at once.
+         * The result is the same as calling
+         *  while( args.size() > 0 )
+         *      list.push_back( args.subcmd_until( predicate ) );
+         * but the argument vector is scanned only once,
+         * and the only allocation is the list of subcommand boundaries.
+         *
+         * Afterwards, size() == 0.
+         */
+        template< typename Predicate >
+        subcmd_list split_subcmds( Predicate && predicate );
+
+        /* Replaces every remaining argument of the form @path
+         * by the arguments contained in the file 'path' (a "response file").
+         *
+         * The file is split into arguments following the quoting rules
+         * of bash (without any kind of expansion):
+         * arguments are separated by whitespace,
+         * a backslash escapes the next character,
+         * single quotes preserve everything up to the next single quote
+         * and double quotes preserve everything but backslash escapes
+         * of $, `, ", \ and newline.
+         *
+         * Where possible, the file is memory-mapped and the arguments
+         * are views into the mapping; only arguments that contain
+         * quotes or backslashes are copied.
+         *
+         * If 'recursive' is true, @path arguments inside response files
+         * are expanded too; a response file that (directly or not)
+         * includes itself is reported (see report) and not expanded again.
+         *
+         * As in GCC, @path arguments that do not name a readable file
+         * are left untouched.
+         */
+        void expand_response_files( bool recursive = false );
+
         /* Sets/retrieves the log stream.
          * This stream should be used to indicate command line argument errors;
          * for instance, operator>> writes to this log
          * if it could not correctly parse some argument.
+         * See also diagnostics, below.
          */
         void log( std::ostream & );
         std::ostream & log();
 
+        /* Sets/retrieves the diagnostics sink.
+         * While a sink is set, the problems that would be written to log()
+         * are recorded in it instead, and are only formatted
+         * when the caller asks the sink to. Pass nullptr to use log() again.
+         *
+         * Like the log, the sink is not inherited by subargument vectors.
+         */
+        void diagnostics( cmdline::diagnostics * );
+        cmdline::diagnostics * diagnostics() const;
+
+        /* Reports a problem with the arguments:
+         * records it in the diagnostics sink, if there is one,
+         * or writes its message to log().
+         * All the messages of this library go through these functions.
+         */
+        void report( const diagnostic & );
+        void report( const cmdline::diagnostics & );
+
         /* Sets/retrieves the program name. */
-        void program_name( const std::string & );
+        void program_name( std::string_view );
+        const std::string & program_name() const;
+
+        /* Retrieves the memory resource used by this object. */
+        std::pmr::memory_resource * resource() const;
+
+        /* Iterators over the remaining arguments, as string views:
+         *  for( std::string_view arg : args ) ...
+         *  std::find( args.begin(), args.end(), "--" );
+         * The iterators are pointers to contiguous storage,
+         * so they are random-access (and, in C++20, contiguous) iterators.
+         *
+         * Iterating does not consume the arguments.
+         * The iterators are invalidated by any non-const member function
+         * except shift, next and the like.
+         */
+        using const_iterator = const std::string_view *;
+        using iterator = const_iterator;
+        const_iterator begin() const;
+        const_iterator end() const;
+
+        /* All the arguments, including the consumed ones;
+         * all()[0] is the first argument after the program name.
+         * Invalidated like begin() and end().
+         */
+        arg_range all() const;
+
+        /* Returns a cursor at the current position; see arg_cursor.
+         * Moving the cursor does not change this object.
+         */
+        arg_cursor cursor() const;
+
+        /* Moves the current position to that of the cursor,
+         * which must have been obtained from this object.
+         * Throws std::invalid_argument otherwise.
+         */
+        void seek( const arg_cursor & );
+
+    private:
+        friend class subcmd_list;
+        friend class args_snapshot;
+        friend class arg_cursor;
+
+        /* Returns a slice of this object from _index to _index + size,
+         * with empty program_name. Does not advance the vector. */
+        args slice( std::size_t size ) const;
+
+        /* Returns the absolute position of the first argument
+         * at or after 'from' satisfying the predicate, or _end if none does. */
+        template< typename Predicate >
+        std::size_t find_until( std::size_t from, Predicate & predicate ) const;
+
+        /* Ensures _backing can be appended to without affecting other slices.
+         * Afterwards, _end == _backing->views.size(). */
+        void make_unique();
+
+        /* Allocates an empty backing from _resource. */
+        std::shared_ptr< backing > make_backing() const;
+
+        /* Empties this object, preparing _backing to be refilled. */
+        void reset();
+
+        /* Whether 'p' may point into memory of this object
+         * that reset() overwrites or releases. */
+        bool owns( const char * p ) const;
+
+        /* Returns 'argv', or pointers to copies of its strings
+         * (kept in 'copies' and 'pointers') if some of them are owned. */
+        char const * const * unalias(
+            int argc,
+            char const * const * argv,
+            std::vector< std::string > & copies,
+            std::vector< const char * > & pointers
+        ) const;
+
+        /* Appends 'arg' to 'into', replacing it by the contents
+         * of the response file it names if 'expand' is true.
+         * 'chain' holds the identities of the files being expanded. */
+        void expand_argument( backing & into, std::string_view arg,
+            bool expand, bool recursive, std::vector< std::string > & chain );
+    };
+
+    /* List of subcommands returned by args::split_subcmds.
+     *
+     * The subcommands are only materialized when accessed;
+     * this object holds a slice of the original argument vector
+     * and the position where each subcommand begins.
+     */
+    class subcmd_list {
+        args _args;
+        std::pmr::vector< std::size_t > _starts;
+        friend class args;
+
+    public:
+        /* Returns the number of subcommands. */
+        std::size_t size() const;
+        bool empty() const;
+
+        /* Returns the program_name of the index-th subcommand,
+         * without constructing it. */
+        std::string_view name( std::size_t index ) const;
+
+        /* Returns the index-th subcommand.
+         * This is an O(1) slice of the original argument vector,
+         * so only the program_name is copied.
+         */
+        args operator[]( std::size_t index ) const;
+    };
+
+    /* Pool of reusable argument vectors.
+     *
+     * Released objects keep their memory, so a program that parses
+     * one command after another, like
+     *  auto cmd = pool.acquire();
+     *  cmd->assign( line );
+     *  ...
+     * stops allocating once every pooled object has grown large enough.
+     */
+    class args_pool {
+        std::vector< std::unique_ptr< args > > _free;
+        std::pmr::memory_resource * _resource;
+
+    public:
+        /* Owns an args acquired from the pool;
+         * gives it back to the pool when destroyed.
+         */
+        class handle {
+            args_pool * _pool;
+            std::unique_ptr< args > _args;
+            friend class args_pool;
+            handle( args_pool * pool, std::unique_ptr< args > args );
+
+        public:
+            handle( handle && ) = default;
+            handle & operator=( handle && );
+            ~handle();
+
+            args & operator*() const { return *_args; }
+            args * operator->() const { return _args.get(); }
+        };
+
+        /* Objects created by the pool will use the given memory resource. */
+        explicit args_pool(
+            std::pmr::memory_resource * resource = std::pmr::get_default_resource()
+        );
+
+        /* Returns an empty argument vector, reusing a released one if any.
+         * Its log is std::cerr and it has no diagnostics sink.
+         * The pool must outlive the handle.
+         */
+        handle acquire();
+
+        /* Returns the number of objects waiting to be reused. */
+        std::size_t size() const;
+
+    private:
+        void release( std::unique_ptr< args > args );
+    };
+
+    /* Independent position in an argument vector, for speculative parsing.
+     *
+     * Use like this:
+     *  auto c = args.cursor();
+     *  if( c.next() == "remote" && c.next() == "add" )
+     *      args.seek( c );     // Commit.
+     *  // Otherwise, args is untouched.
+     *
+     * A cursor is just a pointer to the argument vector and an index,
+     * so saving and restoring a position is a copy of two words:
+     *  auto saved = c;
+     *  ...
+     *  c = saved;
+     *
+     * The cursor sees the arguments of the vector as they are when used,
+     * so it stays valid after push_back and the like,
+     * as long as the argument vector itself exists and is not moved.
+     * After assign, clear or expand_response_files,
+     * the cursor keeps its position() but the arguments are the new ones.
+     * Its members throw and return the same as the args members,
+     * but the arguments are always returned as views.
+     */
+    class arg_cursor {
+        const args * _args;
+        std::size_t _position;  // Relative to _args->_begin.
+        friend class args;
+
+        arg_cursor( const args * args, std::size_t position ) :
+            _args( args ),
+            _position( position )
+        {}
+
+    public:
+        /* Number of arguments after the cursor. */
+        std::size_t size() const;
+        bool empty() const;
+
+        /* Position of the cursor, counted from the first argument
+         * of the argument vector (as in args::total_size). */
+        std::size_t position() const;
+
+        std::string_view peek() const;
+        std::string_view peek( int index ) const;
+        void shift();
+        std::string_view next();
+
+        result< std::string_view > try_peek() const;
+        result< std::string_view > try_peek( int index ) const;
+        error_code try_shift();
+        result< std::string_view > try_next();
+
+        bool operator==( const arg_cursor & other ) const;
+        bool operator!=( const arg_cursor & other ) const;
+    };
+
+    /* Range of arguments returned by args::all;
+     * it does not own the arguments.
+     * In C++20, it is a borrowed view.
+     */
+    class arg_range {
+        const std::string_view * _first;
+        const std::string_view * _last;
+
+    public:
+        using const_iterator = const std::string_view *;
+        using iterator = const_iterator;
+
+        arg_range() : _first( nullptr ), _last( nullptr ) {}
+        arg_range( const_iterator first, const_iterator last ) :
+            _first( first ),
+            _last( last )
+        {}
+
+        const_iterator begin() const { return _first; }
+        const_iterator end() const { return _last; }
+        std::size_t size() const { return _last - _first; }
+        bool empty() const { return _first == _last; }
+        std::string_view operator[]( std::size_t index ) const { return _first[index]; }
+    };
+
+    /* Frozen copy of an argument vector, to be shared between threads.
+     *
+     * Use like this:
+     *  const cmdline::args_snapshot snapshot( args );
+     *  // In each worker thread:
+     *  cmdline::args mine = snapshot.arguments();
+     *  mine >> value;
+     *
+     * The snapshot shares the storage of the original argument vector
+     * instead of copying it. The storage is never modified while shared
+     * (args copies it before writing), and all the members are const,
+     * so any number of threads may use the same snapshot
+     * without synchronization, while the original keeps being used.
+     *
+     * The log and the diagnostics sink are not part of the snapshot.
+     */
+    class args_snapshot {
+        std::shared_ptr< const args::backing > _backing;
+        const std::string_view * _views;
+        std::size_t _size;
+        std::string _program_name;
+        std::pmr::memory_resource * _resource;
+
+    public:
+        /* Takes all the arguments of 'a', including the consumed ones. */
+        explicit args_snapshot( const args & a );
+
+        std::size_t size() const;
+        bool empty() const;
+        std::string_view operator[]( std::size_t index ) const;
         const std::string & program_name() const;
+
+        /* Iterators over all the arguments of the snapshot. */
+        using const_iterator = const std::string_view *;
+        using iterator = const_iterator;
+        const_iterator begin() const;
+        const_iterator end() const;
+
+        /* Returns a new argument vector over the snapshot,
+         * positioned at its first argument, for parsing with operator>>,
+         * options, etc. It shares the storage too,
+         * so only the program name is copied.
+         * Its log is std::cerr and it has no diagnostics sink.
+         */
+        args arguments() const;
+    };
+
+    /* Predicates for args::subarg_until and args::subcmd_until.
+     *
+     * They store views to the strings they are constructed from,
+     * so these strings must outlive the predicates.
+     *
+     * Use like this:
+     *  args.subcmd_until( cmdline::one_of( "--player", "--watcher" ) );
+     */
+
+    /* True for arguments equal to the given token. */
+    struct equals {
+        std::string_view token;
+
+        constexpr explicit equals( std::string_view token ) :
+            token( token )
+        {}
+        constexpr bool operator()( std::string_view arg ) const {
+            return arg == token;
+        }
+    };
+
+    /* True for arguments beginning with the given prefix. */
+    struct starts_with {
+        std::string_view prefix;
+
+        constexpr explicit starts_with( std::string_view prefix ) :
+            prefix( prefix )
+        {}
+        constexpr bool operator()( std::string_view arg ) const {
+            return arg.substr( 0, prefix.size() ) == prefix;
+        }
+    };
+
+    /* True for arguments equal to any of the given tokens. */
+    template< std::size_t N >
+    struct one_of {
+        std::array< std::string_view, N > tokens;
+
+        template< typename ... Tokens >
+        constexpr explicit one_of( const Tokens & ... tokens ) :
+            tokens{ std::string_view( tokens )... }
+        {}
+        constexpr bool operator()( std::string_view arg ) const {
+            for( std::string_view token : tokens )
+                if( arg == token )
+                    return true;
+            return false;
+        }
     };
 
+    template< typename ... Tokens >
+    one_of( const Tokens & ... ) -> one_of< sizeof...(Tokens) >;
+
     /* Class that encapsulate the range information
      * that will be used to parse a number from a cmdline::args,
      * using the operator>> below.
@@ -173,139 +1138,765 @@ namespace cmdline {
      *
      * Note that the number is still parsed and assigned to the
      * operator's right-hand side.
+     *
+     * The bounds are stored with their own types.
+     * Integers are compared exactly, even if their signedness differ;
+     * other types are compared with operator<.
      */
+    template< typename Min, typename Max = Min >
     class range_parser {
-        double min;
-        double max;
+        Min min;
+        Max max;
         cmdline::args & _args;
     public:
-        range_parser( cmdline::args & _args, long long min, long long max ) :
+        range_parser( cmdline::args & _args, Min min, Max max ) :
             min( min ),
             max( max ),
             _args( _args )
         {}
-        range_parser( cmdline::args & _args, long long min ) :
-            min( min ),
-            max( min ),
+        template< typename Number, typename Min_, typename Max_ >
+        friend void operator>>( range_parser< Min_, Max_ > &&, Number & );
+    };
+
+    /* Class returned by args::range< Min, Max >().
+     * Same as range_parser, but with the bounds known at compile time.
+     */
+    template< auto Min, auto Max = Min >
+    class static_range_parser {
+        static_assert( std::is_integral_v< decltype( Min ) > &&
+            std::is_integral_v< decltype( Max ) >,
+            "static_range_parser bounds must be integers." );
+
+        cmdline::args & _args;
+    public:
+        explicit static_range_parser( cmdline::args & _args ) :
             _args( _args )
         {}
-        template< typename Number >
-        friend void operator>>( range_parser &&, Number & );
+        template< typename Number, auto Min_, auto Max_ >
+        friend void operator>>( static_range_parser< Min_, Max_ > &&, Number & );
     };
 
     /* Uses the next() value of 'a' to write to 't'.
-     * Any error that occours are written to a.log().
+     * Any error that occours are reported with a.report().
      *
      * This function is capable of parsing any typename T
      * for which operator>>( std::ostream&, T& ) is defined.
+     *
+     * Integral (except bool and character types) and floating point types
+     * are parsed without a std::stringstream: integers with a dedicated
+     * decimal parser, floating point numbers with std::from_chars
+     * (if the standard library provides it for floating point;
+     * otherwise, they are still parsed with a std::stringstream).
+     * The result and the messages written to a.log() are the same,
+     * except that the parsing does not depend on the global locale,
+     * negative numbers are rejected for unsigned types
+     * and "inf" and "nan" are accepted for floating point types.
      */
     template <typename T>
     args & operator>>( args & a, T & t );
 
 // Class implementation
 
-inline args::args( int argc, char const * const * argv ) {
-    _program_name = argv[0];
-    _args.reserve( argc - 1 );
-    for( int i = 1; i < argc; i++ )
-        _args.push_back( argv[i] );
-    _index = 0;
+namespace detail {
 
-    _log = &std::cerr;
-}
+    inline bool is_space( char c ) {
+        return c == ' ' || c == '\t' || c == '\n' ||
+            c == '\r' || c == '\v' || c == '\f';
+    }
+
+    /* Whitespace, quotes and backslashes. */
+    inline bool is_special( char c ) {
+        return is_space( c ) || c == '\'' || c == '"' || c == '\\';
+    }
+
+    /* Returns the first special character in [first, last), or last. */
+    inline const char * find_special_scalar( const char * first, const char * last ) {
+        while( first != last && !is_special( *first ) )
+            ++first;
+        return first;
+    }
+
+    /* Same as above, but classifies 16 bytes at a time with SSE2
+     * if it is available. */
+    inline const char * find_special( const char * first, const char * last ) {
+#ifdef CMDLINE_SSE2
+        const __m128i space = _mm_set1_epi8( ' ' );
+        const __m128i single_quote = _mm_set1_epi8( '\'' );
+        const __m128i double_quote = _mm_set1_epi8( '"' );
+        const __m128i backslash = _mm_set1_epi8( '\\' );
+        /* '\t' to '\r' are the bytes 9 to 13. Shifting them to -128 to -124
+         * allows a single signed comparison. */
+        const __m128i shift = _mm_set1_epi8( (char) (128 - 9) );
+        const __m128i limit = _mm_set1_epi8( -128 + 5 );
+        for( ; last - first >= 16; first += 16 ) {
+            __m128i v = _mm_loadu_si128( (const __m128i *) first );
+            __m128i hit = _mm_or_si128(
+                _mm_or_si128( _mm_cmpeq_epi8( v, space ), _mm_cmpeq_epi8( v, backslash ) ),
+                _mm_or_si128( _mm_cmpeq_epi8( v, single_quote ), _mm_cmpeq_epi8( v, double_quote ) )
+            );
+            hit = _mm_or_si128( hit, _mm_cmplt_epi8( _mm_add_epi8( v, shift ), limit ) );
+            unsigned mask = (unsigned) _mm_movemask_epi8( hit );
+            if( mask != 0 ) {
+                int offset = 0;
+                while( !(mask >> offset & 1) )
+                    ++offset;
+                return first + offset;
+            }
+        }
+#endif
+        return find_special_scalar( first, last );
+    }
+
+    /* Splits 'text' into words, using the quoting rules described
+     * in args::expand_response_files.
+     *
+     * For each word, calls emit( word, borrowed ).
+     * If 'borrowed' is true, 'word' is a view into 'text';
+     * otherwise, 'word' has been unquoted into a temporary buffer
+     * that will be overwritten by the next word.
+     *
+     * Returns false if the text ended inside quotes or after a backslash.
+     * The words read so far are still emitted.
+     *
+     * The temporary buffer is allocated from 'resource'.
+     *
+     * If 'Vectorized' is false, the runs of ordinary characters
+     * are found one byte at a time; this is the reference implementation
+     * to test find_special against.
+     */
+    template< bool Vectorized = true, typename Emit >
+    bool split_words(
+        std::string_view text,
+        Emit && emit,
+        std::pmr::memory_resource * resource = std::pmr::get_default_resource()
+    ) {
+        auto find = []( const char * first, const char * last ) {
+            if constexpr( Vectorized )
+                return find_special( first, last );
+            else
+                return find_special_scalar( first, last );
+        };
+
+        std::pmr::string buffer( resource );
+        bool ok = true;
+        std::size_t i = 0;
+        std::size_t n = text.size();
+        const char * data = text.data();
+        while( true ) {
+            while( i < n && is_space( text[i] ) )
+                ++i;
+            if( i == n )
+                return ok;
+
+            /* Fast path: words without quotes nor backslashes. */
+            std::size_t begin = i;
+            i = find( data + i, data + n ) - data;
+            if( i == n || is_space( text[i] ) ) {
+                emit( text.substr( begin, i - begin ), true );
+                continue;
+            }
+
+            buffer.assign( data + begin, i - begin );
+            while( i < n && !is_space( text[i] ) ) {
+                if( !is_special( text[i] ) ) {
+                    std::size_t run = find( data + i, data + n ) - data;
+                    buffer.append( data + i, run - i );
+                    i = run;
+                    continue;
+                }
+                char c = text[i++];
+                if( c == '\\' ) {
+                    if( i == n )
+                        ok = false;
+                    else if( text[i] == '\n' )
+                        ++i; // Line continuation.
+                    else
+                        buffer += text[i++];
+                }
+                else if( c == '\'' ) {
+                    std::size_t close = text.find( '\'', i );
+                    if( close == text.npos ) {
+                        ok = false;
+                        close = n;
+                    }
+                    buffer.append( text.data() + i, close - i );
+                    i = close == n ? n : close + 1;
+                }
+                else if( c == '"' ) {
+                    while( i < n && text[i] != '"' ) {
+                        if( text[i] == '\\' && i + 1 < n ) {
+                            char next = text[i+1];
+                            if( next == '\n' ) {
+                                i += 2;
+                                continue;
+                            }
+                            if( next == '$' || next == '`' || next == '"' || next == '\\' ) {
+                                buffer += next;
+                                i += 2;
+                                continue;
+                            }
+                        }
+                        buffer += text[i++];
+                    }
+                    if( i == n )
+                        ok = false;
+                    else
+                        ++i;
+                }
+                else
+                    buffer += c;
+            }
+            emit( std::string_view( buffer ), false );
+        }
+    }
+
+    /* Read-only contents of a file, memory-mapped where possible. */
+    class file_contents {
+        std::string_view _text;
+        std::string _identity;
+#ifdef CMDLINE_POSIX
+        void * _map = nullptr;
+#else
+        std::string _data;
+#endif
+        file_contents() = default;
+
+    public:
+        file_contents( const file_contents & ) = delete;
+        file_contents & operator=( const file_contents & ) = delete;
+        ~file_contents();
+
+        /* Opens the file; returns nullptr if it could not be read. */
+        static std::shared_ptr< const file_contents > open( const std::string & path );
+
+        std::string_view text() const { return _text; }
+
+        /* A string that is the same for any path naming this file. */
+        const std::string & identity() const { return _identity; }
+    };
+
+#ifdef CMDLINE_POSIX
+
+    inline file_contents::~file_contents() {
+        if( _map )
+            munmap( _map, _text.size() );
+    }
+
+    inline std::shared_ptr< const file_contents > file_contents::open(
+        const std::string & path
+    ) {
+        int fd = ::open( path.c_str(), O_RDONLY );
+        if( fd < 0 )
+            return nullptr;
+
+        struct stat st;
+        if( fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) ) {
+            close( fd );
+            return nullptr;
+        }
+
+        std::shared_ptr< file_contents > ret( new file_contents );
+        ret->_identity = std::to_string( st.st_dev ) + ":" + std::to_string( st.st_ino );
+        if( st.st_size > 0 ) {
+            void * map = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+            if( map == MAP_FAILED ) {
+                close( fd );
+                return nullptr;
+            }
+            ret->_map = map;
+            ret->_text = std::string_view( (const char *) map, st.st_size );
+        }
+        close( fd );
+        return ret;
+    }
+
+#else
+
+    inline file_contents::~file_contents() {}
+
+    inline std::shared_ptr< const file_contents > file_contents::open(
+        const std::string & path
+    ) {
+        std::ifstream file( path, std::ios::binary );
+        if( !file )
+            return nullptr;
+
+        std::shared_ptr< file_contents > ret( new file_contents );
+        ret->_data.assign( std::istreambuf_iterator<char>( file ),
+            std::istreambuf_iterator<char>() );
+        ret->_text = ret->_data;
+        /* Without device and inode numbers, the canonical path is the best
+         * identity we have; "a.rsp" and "./a.rsp" must compare equal. */
+        std::error_code error;
+        std::filesystem::path canonical = std::filesystem::canonical( path, error );
+        ret->_identity = error ? path : canonical.string();
+        return ret;
+    }
+
+#endif // CMDLINE_POSIX
+
+} // namespace detail
+
+inline args::args(
+    int argc,
+    char const * const * argv,
+    std::pmr::memory_resource * resource
+) :
+    args( resource )
+{
+    assign( argc, argv );
+}
+
+inline args::args(
+    int argc,
+    char const * const * argv,
+    borrow_argv_t,
+    std::pmr::memory_resource * resource
+) :
+    args( resource )
+{
+    assign( argc, argv, borrow_argv );
+}
 
-inline args::args() {
-    _index = 0;
+inline args::args(
+    std::string_view command_line,
+    std::pmr::memory_resource * resource
+) :
+    args( resource )
+{
+    assign( command_line );
+}
+
+inline args::args() :
+    args( std::pmr::get_default_resource() )
+{}
+
+inline args::args( std::pmr::memory_resource * resource ) {
+    _resource = resource;
+    _begin = _end = _index = 0;
     _log = &std::cerr;
+    _diagnostics = nullptr;
+}
+
+inline args::args( args && other ) noexcept :
+    _backing( std::move( other._backing ) ),
+    _begin( other._begin ),
+    _end( other._end ),
+    _index( other._index ),
+    _program_name( std::move( other._program_name ) ),
+    _resource( other._resource ),
+    _log( other._log ),
+    _diagnostics( other._diagnostics )
+{
+    other._begin = other._end = other._index = 0;
+}
+
+inline args & args::operator=( args && other ) noexcept {
+    if( this == &other )
+        return *this;
+    _backing = std::move( other._backing );
+    _begin = other._begin;
+    _end = other._end;
+    _index = other._index;
+    _program_name = std::move( other._program_name );
+    _resource = other._resource;
+    _log = other._log;
+    _diagnostics = other._diagnostics;
+    other._begin = other._end = other._index = 0;
+    return *this;
+}
+
+inline void args::assign( int argc, char const * const * argv ) {
+    std::vector< std::string > copies;
+    std::vector< const char * > pointers;
+    argv = unalias( argc, argv, copies, pointers );
+
+    reset();
+    _program_name = argv[0];
+    auto & views = _backing->views;
+    views.reserve( argc - 1 );
+
+    std::size_t total = 0;
+    for( int i = 1; i < argc; i++ )
+        total += std::strlen( argv[i] );
+
+    std::pmr::string & buffer = _backing->new_string();
+    buffer.reserve( total );
+    for( int i = 1; i < argc; i++ ) {
+        std::size_t begin = buffer.size();
+        buffer += argv[i];
+        /* No reallocation can happen here, so the previous views are safe. */
+        views.emplace_back( buffer.data() + begin, buffer.size() - begin );
+    }
+    _end = views.size();
+}
+
+inline void args::assign( int argc, char const * const * argv, borrow_argv_t ) {
+    /* Borrowing our own memory would leave dangling views. */
+    for( int i = 0; i < argc; i++ )
+        if( owns( argv[i] ) )
+            return assign( argc, argv );
+
+    reset();
+    _program_name = argv[0];
+    auto & views = _backing->views;
+    views.reserve( argc - 1 );
+    for( int i = 1; i < argc; i++ )
+        views.emplace_back( argv[i] );
+    _end = views.size();
+}
+
+inline void args::assign( std::string_view command_line ) {
+    std::string copy;
+    if( owns( command_line.data() ) ) {
+        copy.assign( command_line );
+        command_line = copy;
+    }
+
+    reset();
+    std::string_view text = _backing->store( command_line );
+    bool ok = detail::split_words( text,
+        [this]( std::string_view word, bool borrowed ) {
+            if( !borrowed )
+                word = _backing->store( word );
+            _backing->views.push_back( word );
+        }, _resource );
+    if( !ok ) {
+        reset();
+        throw std::invalid_argument( "Unterminated quote or trailing backslash." );
+    }
+    _end = _backing->views.size();
+}
+
+inline void args::clear() {
+    if( _backing && _backing.use_count() == 1 )
+        _backing->clear();
+    else
+        _backing.reset();
+    _begin = _end = _index = 0;
+    _program_name.clear();
 }
 
 inline std::size_t args::size() const {
-    return _args.size() - _index;
+    return _end - _index;
 }
 
 inline std::size_t args::total_size() const {
-    return _args.size();
+    return _end - _begin;
 }
 
 inline std::string args::peek() const {
-    if( _index >= _args.size() )
+    return std::string( peek_view() );
+}
+
+inline std::string args::peek( int index ) const {
+    return std::string( peek_view( index ) );
+}
+
+inline std::string_view args::peek_view() const {
+    auto ret = try_peek();
+    if( !ret )
         throw std::out_of_range( "No argument left to peek." );
 
-    return _args[_index];
+    return *ret;
 }
 
-inline std::string args::peek( int index ) const {
-    if( _index + index >= _args.size() )
+inline std::string_view args::peek_view( int index ) const {
+    auto ret = try_peek( index );
+    if( ret.error() == error_code::vector_too_short )
         throw std::out_of_range( "Argument vector too short." );
-    if( _index + index < 0 )
+    if( ret.error() == error_code::negative_index )
         throw std::out_of_range( "The index must not become negative." );
 
-    return _args[_index + index];
+    return *ret;
 }
 
 inline void args::shift() {
-    if( _index >= _args.size() )
+    if( try_shift() != error_code::none )
         throw std::out_of_range( "No arguments left to shift." );
+}
+
+inline std::string args::next() {
+    return std::string( next_view() );
+}
+
+inline std::string_view args::next_view() {
+    auto ret = try_next();
+    if( !ret )
+        throw std::out_of_range( "No argument left to peek." );
+
+    return *ret;
+}
+
+inline result< std::string_view > args::try_peek() const {
+    if( _index >= _end )
+        return error_code::no_arguments_left;
+
+    return _backing->views[_index];
+}
+
+inline result< std::string_view > args::try_peek( int index ) const {
+    if( index >= 0 && size() <= (std::size_t) index )
+        return error_code::vector_too_short;
+    if( index < 0 && _index - _begin < (std::size_t) -(long long) index )
+        return error_code::negative_index;
+
+    return _backing->views[_index + index];
+}
+
+inline error_code args::try_shift() {
+    if( _index >= _end )
+        return error_code::no_arguments_left;
 
     _index++;
+    return error_code::none;
 }
 
-inline std::string args::next() {
-    /* Peek takes care of throwing for us. */
-    std::string ret = peek();
-    shift();
+inline result< std::string_view > args::try_next() {
+    auto ret = try_peek();
+    if( ret )
+        _index++;
     return ret;
 }
 
-inline void args::push_back( std::string str ) {
-    _args.push_back( str );
+inline void args::push_back( const std::string & str ) {
+    emplace_back( str );
+}
+
+inline void args::push_back( std::string && str ) {
+    make_unique();
+    /* Reserve first, so that nothing throws after 'str' is moved from. */
+    _backing->reserve_views( 1 );
+    _backing->adopted.emplace_back( std::move( str ) );
+    _backing->views.push_back( _backing->adopted.back() );
+    _end++;
+}
+
+inline void args::emplace_back( std::string_view str ) {
+    make_unique();
+    std::string_view stored = _backing->store( str );
+    /* If this throws, the string will merely linger in the backing. */
+    _backing->views.push_back( stored );
+    _end++;
+}
+
+template< typename Range >
+void args::append( const Range & range ) {
+    std::size_t count = 0;
+    std::size_t total = 0;
+    bool aliased = false;   // Whether the range lives in _backing->views.
+    std::less< const void * > lt;
+    for( const auto & str : range ) {
+        count++;
+        total += std::string_view( str ).size();
+        if( _backing && !lt( &str, _backing->views.data() ) &&
+                lt( &str, _backing->views.data() + _backing->views.size() ) )
+            aliased = true;
+    }
+    if( count == 0 )
+        return;
+
+    /* Growing the views would free the range before the second pass;
+     * keeping another reference makes make_unique move to a new backing,
+     * leaving the old views untouched as its parent. */
+    std::shared_ptr< const backing > keep;
+    if( aliased )
+        keep = _backing;
+    make_unique();
+    _backing->reserve_views( count );
+    auto & views = _backing->views;
+    std::pmr::string & buffer = _backing->new_string();
+    buffer.reserve( total );
+    for( const auto & str : range ) {
+        std::size_t begin = buffer.size();
+        buffer += std::string_view( str );
+        /* No reallocation can happen here, so the previous views are safe. */
+        views.emplace_back( buffer.data() + begin, buffer.size() - begin );
+    }
+    _end = views.size();
+}
+
+template< typename Min >
+range_parser< Min, Min > args::range( Min min ) {
+    return range_parser< Min, Min >( *this, min, min );
 }
 
-inline range_parser args::range( double min ) {
-    return range_parser( *this, min );
+template< typename Min, typename Max >
+range_parser< Min, Max > args::range( Min min, Max max ) {
+    return range_parser< Min, Max >( *this, min, max );
 }
 
-inline range_parser args::range( double min, double max ) {
-    return range_parser( *this, min, max );
+template< auto Min, auto Max >
+static_range_parser< Min, Max > args::range() {
+    return static_range_parser< Min, Max >( *this );
 }
 
 inline args args::subarg( std::size_t size ) {
-    if( _index + size >= _args.size() + 1 )
+    auto ret = try_subarg( size );
+    if( !ret )
         throw std::out_of_range( "Not enough arguments to form subarg." );
 
-    args ret;
-    ret._args = std::vector<std::string>(
-        _args.begin() + _index,
-        _args.begin() + _index + size
-    );
-    _index += size;
-    return ret;
+    return std::move( *ret );
 }
 
 inline args args::subarg_until( bool (* predicate )(const std::string&) ) {
-    args ret;
-    auto it = _args.begin() + _index;
-    unsigned size = 0;
-    for( ; it < _args.end(); ++it, ++size )
-        if( predicate( *it ) )
-            break;
-
-    ret._args = std::vector<std::string>( _args.begin() + _index, it );
+    return subarg_until< bool (*)(const std::string&) >( std::move(predicate) );
+}
+
+namespace detail {
+
+    /* Calls the predicate with a string_view if possible,
+     * and with a std::string otherwise. */
+    template< typename Predicate >
+    bool test( Predicate & predicate, std::string_view arg ) {
+        if constexpr( std::is_invocable_r_v< bool, Predicate &, std::string_view > )
+            return std::invoke( predicate, arg );
+        else
+            return std::invoke( predicate, std::string( arg ) );
+    }
+
+    /* Token sets recognized by find_token. */
+    template< typename Predicate >
+    inline constexpr bool is_token_set = false;
+    template<>
+    inline constexpr bool is_token_set< equals > = true;
+    template< std::size_t N >
+    inline constexpr bool is_token_set< one_of<N> > = true;
+
+    inline std::array< std::string_view, 1 > tokens_of( const equals & pred ) {
+        return { pred.token };
+    }
+    template< std::size_t N >
+    const std::array< std::string_view, N > & tokens_of( const one_of<N> & pred ) {
+        return pred.tokens;
+    }
+
+    /* Returns the first view in [first, last) equal to some token,
+     * or last if there is none.
+     *
+     * Each argument is first filtered by its length and first byte,
+     * using bitmaps built from the tokens;
+     * only the arguments that pass are fully compared.
+     * Tokens with 64 bytes or more are always fully compared. */
+    template< std::size_t N >
+    const std::string_view * find_token(
+        const std::string_view * first,
+        const std::string_view * last,
+        const std::array< std::string_view, N > & tokens
+    ) {
+        std::uint64_t lengths = 0;
+        std::uint64_t bytes[4] = {};
+        bool long_tokens = false;
+        for( std::string_view token : tokens ) {
+            if( token.size() >= 64 ) {
+                long_tokens = true;
+                continue;
+            }
+            lengths |= std::uint64_t(1) << token.size();
+            /* Empty strings have first byte zero. */
+            unsigned char byte = token.empty() ? 0 : (unsigned char) token[0];
+            bytes[byte / 64] |= std::uint64_t(1) << byte % 64;
+        }
+
+        for( ; first != last; ++first ) {
+            std::size_t size = first->size();
+            if( size < 64 ) {
+                if( !(lengths >> size & 1) )
+                    continue;
+                unsigned char byte = size == 0 ? 0 : (unsigned char) (*first)[0];
+                if( !(bytes[byte / 64] >> byte % 64 & 1) )
+                    continue;
+            }
+            else if( !long_tokens )
+                continue;
+
+            for( std::string_view token : tokens )
+                if( *first == token )
+                    return first;
+        }
+        return last;
+    }
+
+} // namespace detail
+
+template< typename Predicate >
+std::size_t args::find_until( std::size_t from, Predicate & predicate ) const {
+    if( from >= _end )
+        return _end;
+
+    if constexpr( detail::is_token_set< std::decay_t<Predicate> > ) {
+        const std::string_view * views = _backing->views.data();
+        return detail::find_token( views + from, views + _end,
+            detail::tokens_of( predicate ) ) - views;
+    }
+    else {
+        for( ; from < _end; ++from )
+            if( detail::test( predicate, _backing->views[from] ) )
+                break;
+        return from;
+    }
+}
+
+template< typename Predicate >
+args args::subarg_until( Predicate && predicate ) {
+    std::size_t size = find_until( _index, predicate ) - _index;
+    args ret = slice( size );
     _index += size;
     return ret;
 }
 
 inline args args::subcmd( std::size_t size ) {
-    std::string name = next();
-    args ret = subarg( size );
+    auto ret = try_subcmd( size );
+    if( ret.error() == error_code::no_arguments_left )
+        throw std::out_of_range( "No argument left to peek." );
+    if( ret.error() == error_code::not_enough_arguments )
+        throw std::out_of_range( "Not enough arguments to form subarg." );
+
+    return std::move( *ret );
+}
+
+inline args args::subcmd_until( bool (* predicate )(const std::string&) ) {
+    return subcmd_until< bool (*)(const std::string&) >( std::move(predicate) );
+}
+
+template< typename Predicate >
+args args::subcmd_until( Predicate && predicate ) {
+    std::string_view name = next_view();
+    args ret = subarg_until( std::forward<Predicate>(predicate) );
     ret.program_name( name );
     return ret;
 }
 
-inline args args::subcmd_until( bool (* predicate )(const std::string&) ) {
-    std::string name = next();
-    args ret = subarg_until( predicate );
+template< typename Predicate >
+subcmd_list args::split_subcmds( Predicate && predicate ) {
+    subcmd_list ret;
+    ret._args = slice( size() );
+    ret._starts = std::pmr::vector< std::size_t >( _resource );
+    for( std::size_t i = _index; i < _end; i = find_until( i + 1, predicate ) )
+        ret._starts.push_back( i );
+    _index = _end;
+    return ret;
+}
+
+inline result< args > args::try_subarg( std::size_t size ) {
+    if( size > this->size() )
+        return error_code::not_enough_arguments;
+
+    args ret = slice( size );
+    _index += size;
+    return ret;
+}
+
+inline result< args > args::try_subcmd( std::size_t size ) {
+    if( this->size() == 0 )
+        return error_code::no_arguments_left;
+    if( size > this->size() - 1 )
+        return error_code::not_enough_arguments;
+
+    std::string_view name = _backing->views[_index++];
+    args ret = slice( size );
     ret.program_name( name );
+    _index += size;
     return ret;
 }
 
@@ -317,7 +1908,29 @@ inline std::ostream & args::log() {
     return *_log;
 }
 
-inline void args::program_name( const std::string & name ) {
+inline void args::diagnostics( cmdline::diagnostics * sink ) {
+    _diagnostics = sink;
+}
+
+inline cmdline::diagnostics * args::diagnostics() const {
+    return _diagnostics;
+}
+
+inline void args::report( const diagnostic & d ) {
+    if( _diagnostics )
+        _diagnostics->push_back( d );
+    else
+        *_log << d;
+}
+
+inline void args::report( const cmdline::diagnostics & d ) {
+    if( _diagnostics )
+        _diagnostics->append( d );
+    else
+        d.format( *_log );
+}
+
+inline void args::program_name( std::string_view name ) {
     _program_name = name;
 }
 
@@ -325,48 +1938,1142 @@ inline const std::string & args::program_name() const {
     return _program_name;
 }
 
+inline std::pmr::memory_resource * args::resource() const {
+    return _resource;
+}
+
+inline args::const_iterator args::begin() const {
+    return _backing ? _backing->views.data() + _index : nullptr;
+}
+
+inline args::const_iterator args::end() const {
+    return _backing ? _backing->views.data() + _end : nullptr;
+}
+
+inline arg_range args::all() const {
+    if( !_backing )
+        return arg_range();
+    return arg_range( _backing->views.data() + _begin, _backing->views.data() + _end );
+}
+
+inline arg_cursor args::cursor() const {
+    return arg_cursor( this, _index - _begin );
+}
+
+inline void args::seek( const arg_cursor & c ) {
+    if( c._args != this )
+        throw std::invalid_argument( "Cursor from another argument vector." );
+    _index = _begin + std::min( c._position, total_size() );
+}
+
+inline args args::slice( std::size_t size ) const {
+    args ret( _resource );
+    ret._backing = _backing;
+    ret._begin = ret._index = _index;
+    ret._end = _index + size;
+    return ret;
+}
+
+inline void args::expand_response_files( bool recursive ) {
+    bool found = false;
+    for( std::size_t i = _index; i < _end && !found; i++ )
+        found = _backing->views[i].size() > 1 && _backing->views[i][0] == '@';
+    if( !found )
+        return;
+
+    auto copy = make_backing();
+    copy->parent = _backing;
+    copy->views.assign(
+        _backing->views.begin() + _begin,
+        _backing->views.begin() + _index
+    );
+    std::vector< std::string > chain;
+    for( std::size_t i = _index; i < _end; i++ )
+        expand_argument( *copy, _backing->views[i], true, recursive, chain );
+
+    _backing = std::move( copy );
+    _index -= _begin;
+    _begin = 0;
+    _end = _backing->views.size();
+}
+
+inline void args::expand_argument(
+    backing & into,
+    std::string_view arg,
+    bool expand,
+    bool recursive,
+    std::vector< std::string > & chain
+) {
+    if( !expand || arg.size() < 2 || arg[0] != '@' ) {
+        into.views.push_back( arg );
+        return;
+    }
+
+    std::string path( arg.substr( 1 ) );
+    auto file = detail::file_contents::open( path );
+    if( !file ) {
+        into.views.push_back( arg );
+        return;
+    }
+    for( const std::string & identity : chain )
+        if( identity == file->identity() ) {
+            diagnostic d{ diagnostic_kind::recursive_response_file };
+            d.text = path;
+            report( d );
+            return;
+        }
+
+    into.resources.push_back( file );
+    chain.push_back( file->identity() );
+    bool ok = detail::split_words( file->text(),
+        [&]( std::string_view word, bool borrowed ) {
+            if( !borrowed )
+                word = into.store( word );
+            expand_argument( into, word, recursive, recursive, chain );
+        }, _resource );
+    chain.pop_back();
+    if( !ok ) {
+        diagnostic d{ diagnostic_kind::unterminated_quote };
+        d.text = path;
+        report( d );
+    }
+}
+
+inline std::shared_ptr< args::backing > args::make_backing() const {
+    return std::allocate_shared< backing >(
+        std::pmr::polymorphic_allocator< backing >( _resource ), _resource );
+}
+
+inline bool args::owns( const char * p ) const {
+    std::less_equal< const char * > le;
+    if( le( _program_name.data(), p ) &&
+            le( p, _program_name.data() + _program_name.size() ) )
+        return true;
+    /* If the storage is shared, reset() leaves it to the other owners. */
+    return _backing && _backing.use_count() == 1 && _backing->may_own( p );
+}
+
+inline char const * const * args::unalias(
+    int argc,
+    char const * const * argv,
+    std::vector< std::string > & copies,
+    std::vector< const char * > & pointers
+) const {
+    int i = 0;
+    while( i < argc && !owns( argv[i] ) )
+        i++;
+    if( i == argc )
+        return argv;
+
+    copies.assign( argv, argv + argc );
+    pointers.reserve( argc );
+    for( const std::string & copy : copies )
+        pointers.push_back( copy.c_str() );
+    return pointers.data();
+}
+
+inline void args::reset() {
+    /* Set the object to empty first, in case make_backing throws. */
+    _begin = _end = _index = 0;
+    _program_name.clear();
+    if( _backing && _backing.use_count() == 1 )
+        _backing->clear();
+    else {
+        _backing.reset();
+        _backing = make_backing();
+    }
+}
+
+inline void args::make_unique() {
+    if( _backing && _backing.use_count() == 1
+            && _end == _backing->views.size() )
+        return;
+
+    auto copy = make_backing();
+    if( _backing ) {
+        copy->views.assign(
+            _backing->views.begin() + _begin,
+            _backing->views.begin() + _end
+        );
+        copy->parent = _backing;
+    }
+    /* Nothing changes before this point, so strong guarantee still holds. */
+    _backing = std::move( copy );
+    _index -= _begin;
+    _end -= _begin;
+    _begin = 0;
+}
+
+inline const char * message( error_code error ) {
+    switch( error ) {
+        case error_code::none:
+            return "No error.";
+        case error_code::no_arguments_left:
+            return "No argument left.";
+        case error_code::vector_too_short:
+            return "Argument vector too short.";
+        case error_code::negative_index:
+            return "The index must not become negative.";
+        case error_code::not_enough_arguments:
+            return "Not enough arguments to form subarg.";
+    }
+    return "Unknown error.";
+}
+
+inline std::ostream & operator<<( std::ostream & os, const diagnostic & d ) {
+    auto bound = [&os]( const diagnostic::bound_type & b ) -> std::ostream & {
+        std::visit( [&os]( const auto & value ) {
+            if constexpr( !std::is_same_v< std::decay_t<decltype(value)>, std::monostate > )
+                os << value;
+        }, b );
+        return os;
+    };
+    auto subject = [&os, &d]() -> std::ostream & {
+        if( d.context.empty() )
+            return os << "Error: number";
+        return os << "Error: argument to " << d.context;
+    };
+
+    switch( d.kind ) {
+        case diagnostic_kind::could_not_parse:
+            return os << "Error: could not parse " << d.text << ".\n";
+        case diagnostic_kind::partially_parsed:
+            return os << "Warning: partially parsed string\n"
+                << "Unparsed bit: '" << d.context << "'\n";
+        case diagnostic_kind::below_minimum:
+            subject() << " must be greater than ";
+            return bound( d.bound ) << ".\n";
+        case diagnostic_kind::above_maximum:
+            subject() << " must be smaller than ";
+            return bound( d.bound ) << ".\n";
+        case diagnostic_kind::extract_failed:
+            return os << "Error: " << d.count << " of " << d.total
+                << " values could not be parsed:\n";
+        case diagnostic_kind::recursive_response_file:
+            return os << "Error: response file " << d.text << " includes itself.\n";
+        case diagnostic_kind::unterminated_quote:
+            return os << "Warning: unterminated quote in response file "
+                << d.text << ".\n";
+        case diagnostic_kind::unknown_option:
+            return os << "Error: unknown option " << d.text << ".\n";
+        case diagnostic_kind::missing_option_argument:
+            return os << "Error: option " << d.text << " requires "
+                << d.count << " argument" << (d.count == 1 ? "" : "s") << ".\n";
+    }
+    return os;
+}
+
+inline diagnostics::diagnostics( std::pmr::memory_resource * resource ) :
+    _entries( resource ),
+    _chunks( resource )
+{}
+
+inline diagnostics::diagnostics( const diagnostics & other ) :
+    diagnostics( other.resource() )
+{
+    append( other );
+}
+
+inline diagnostics & diagnostics::operator=( const diagnostics & other ) {
+    if( this != &other ) {
+        clear();
+        append( other );
+    }
+    return *this;
+}
+
+inline diagnostics & diagnostics::operator=( diagnostics && other ) {
+    if( this == &other )
+        return *this;
+    /* With different resources, moving the chunks would copy them,
+     * invalidating the views of the entries. */
+    if( resource() != other.resource() )
+        return *this = static_cast< const diagnostics & >( other );
+    _entries = std::move( other._entries );
+    _chunks = std::move( other._chunks );
+    other.clear();
+    return *this;
+}
+
+inline std::pmr::memory_resource * diagnostics::resource() const {
+    return _entries.get_allocator().resource();
+}
+
+inline std::size_t diagnostics::size() const {
+    return _entries.size();
+}
+
+inline bool diagnostics::empty() const {
+    return _entries.empty();
+}
+
+inline const diagnostic & diagnostics::operator[]( std::size_t i ) const {
+    return _entries[i];
+}
+
+inline diagnostics::const_iterator diagnostics::begin() const {
+    return _entries.begin();
+}
+
+inline diagnostics::const_iterator diagnostics::end() const {
+    return _entries.end();
+}
+
+inline void diagnostics::push_back( const diagnostic & d ) {
+    diagnostic copy = d;
+    copy.text = store( d.text );
+    copy.context = store( d.context );
+    if( auto * text = std::get_if< std::string_view >( &d.bound ) )
+        copy.bound = store( *text );
+    _entries.push_back( copy );
+}
+
+inline void diagnostics::append( const diagnostics & other ) {
+    _entries.reserve( _entries.size() + other.size() );
+    for( const diagnostic & d : other )
+        push_back( d );
+}
+
+inline void diagnostics::clear() {
+    _entries.clear();
+    _chunks.clear();
+}
+
+inline void diagnostics::format( std::ostream & os ) const {
+    os << str();
+}
+
+inline std::string diagnostics::str() const {
+    std::ostringstream os;
+    for( std::size_t i = 0; i < _entries.size(); i++ ) {
+        const diagnostic & d = _entries[i];
+        os << d;
+        if( d.kind != diagnostic_kind::extract_failed )
+            continue;
+
+        for( std::size_t j = 0; j < d.count && i + 1 < _entries.size(); j++ ) {
+            const diagnostic & value = _entries[++i];
+            os << "  value " << value.index - d.index << ": ";
+            if( value.kind == diagnostic_kind::partially_parsed )
+                os << "partially parsed string; unparsed bit: '"
+                    << value.context << "'\n";
+            else
+                os << "could not parse " << value.text << ".\n";
+        }
+    }
+    return os.str();
+}
+
+inline std::string_view diagnostics::store( std::string_view str ) {
+    if( str.empty() )
+        return std::string_view();
+    if( _chunks.empty() ||
+            _chunks.back().capacity() - _chunks.back().size() < str.size() ) {
+        /* Strings larger than a chunk get a chunk of their own. */
+        _chunks.emplace_back();
+        _chunks.back().reserve( std::max( chunk_size, str.size() ) );
+    }
+    std::pmr::string & chunk = _chunks.back();
+    std::size_t begin = chunk.size();
+    chunk += str;
+    return std::string_view( chunk.data() + begin, str.size() );
+}
+
+inline std::size_t subcmd_list::size() const {
+    return _starts.size();
+}
+
+inline bool subcmd_list::empty() const {
+    return _starts.empty();
+}
+
+inline std::string_view subcmd_list::name( std::size_t index ) const {
+    return _args._backing->views[_starts[index]];
+}
+
+inline args subcmd_list::operator[]( std::size_t index ) const {
+    args ret = _args;
+    ret._begin = ret._index = _starts[index] + 1;
+    if( index + 1 < _starts.size() )
+        ret._end = _starts[index + 1];
+    ret.program_name( name( index ) );
+    return ret;
+}
+
+inline args_pool::args_pool( std::pmr::memory_resource * resource ) :
+    _resource( resource )
+{}
+
+inline args_pool::handle args_pool::acquire() {
+    if( _free.empty() )
+        return handle( this, std::make_unique< args >( _resource ) );
+
+    std::unique_ptr< args > ret = std::move( _free.back() );
+    _free.pop_back();
+    return handle( this, std::move( ret ) );
+}
+
+inline std::size_t args_pool::size() const {
+    return _free.size();
+}
+
+inline void args_pool::release( std::unique_ptr< args > args ) {
+    args->clear();
+    args->log( std::cerr );
+    args->diagnostics( nullptr );
+    try {
+        _free.push_back( std::move( args ) );
+    }
+    catch( ... ) {
+        /* Then the object is simply destroyed. */
+    }
+}
+
+inline args_pool::handle::handle( args_pool * pool, std::unique_ptr< args > args ) :
+    _pool( pool ),
+    _args( std::move( args ) )
+{}
+
+inline args_pool::handle & args_pool::handle::operator=( handle && other ) {
+    if( this != &other ) {
+        if( _args )
+            _pool->release( std::move( _args ) );
+        _pool = other._pool;
+        _args = std::move( other._args );
+    }
+    return *this;
+}
+
+inline args_pool::handle::~handle() {
+    if( _args )
+        _pool->release( std::move( _args ) );
+}
+
+inline std::size_t arg_cursor::size() const {
+    std::size_t total = _args->total_size();
+    return _position < total ? total - _position : 0;
+}
+
+inline bool arg_cursor::empty() const {
+    return size() == 0;
+}
+
+inline std::size_t arg_cursor::position() const {
+    return _position;
+}
+
+inline std::string_view arg_cursor::peek() const {
+    auto ret = try_peek();
+    if( !ret )
+        throw std::out_of_range( "No argument left to peek." );
+    return *ret;
+}
+
+inline std::string_view arg_cursor::peek( int index ) const {
+    auto ret = try_peek( index );
+    if( ret.error() == error_code::vector_too_short )
+        throw std::out_of_range( "Argument vector too short." );
+    if( ret.error() == error_code::negative_index )
+        throw std::out_of_range( "The index must not become negative." );
+    return *ret;
+}
+
+inline void arg_cursor::shift() {
+    if( try_shift() != error_code::none )
+        throw std::out_of_range( "No arguments left to shift." );
+}
+
+inline std::string_view arg_cursor::next() {
+    auto ret = try_next();
+    if( !ret )
+        throw std::out_of_range( "No argument left to peek." );
+    return *ret;
+}
+
+inline result< std::string_view > arg_cursor::try_peek() const {
+    if( empty() )
+        return error_code::no_arguments_left;
+    return _args->_backing->views[_args->_begin + _position];
+}
+
+inline result< std::string_view > arg_cursor::try_peek( int index ) const {
+    /* The vector may have shrunk below the cursor since it was created. */
+    std::size_t position = std::min( _position, _args->total_size() );
+    if( index >= 0 && size() <= (std::size_t) index )
+        return error_code::vector_too_short;
+    if( index < 0 && position < (std::size_t) -(long long) index )
+        return error_code::negative_index;
+    return _args->_backing->views[_args->_begin + position + index];
+}
+
+inline error_code arg_cursor::try_shift() {
+    if( empty() )
+        return error_code::no_arguments_left;
+    _position++;
+    return error_code::none;
+}
+
+inline result< std::string_view > arg_cursor::try_next() {
+    auto ret = try_peek();
+    if( ret )
+        _position++;
+    return ret;
+}
+
+inline bool arg_cursor::operator==( const arg_cursor & other ) const {
+    return _args == other._args && _position == other._position;
+}
+
+inline bool arg_cursor::operator!=( const arg_cursor & other ) const {
+    return !( *this == other );
+}
+
+inline args_snapshot::args_snapshot( const args & a ) :
+    _backing( a._backing ),
+    _views( a._backing ? a._backing->views.data() + a._begin : nullptr ),
+    _size( a._end - a._begin ),
+    _program_name( a._program_name ),
+    _resource( a._resource )
+{}
+
+inline std::size_t args_snapshot::size() const {
+    return _size;
+}
+
+inline bool args_snapshot::empty() const {
+    return _size == 0;
+}
+
+inline std::string_view args_snapshot::operator[]( std::size_t index ) const {
+    return _views[index];
+}
+
+inline const std::string & args_snapshot::program_name() const {
+    return _program_name;
+}
+
+inline args_snapshot::const_iterator args_snapshot::begin() const {
+    return _views;
+}
+
+inline args_snapshot::const_iterator args_snapshot::end() const {
+    return _views + _size;
+}
+
+inline args args_snapshot::arguments() const {
+    args ret( _resource );
+    ret._program_name = _program_name;
+    if( _size == 0 )
+        return ret;
+
+    /* ret never writes to a shared backing, so the cast is safe. */
+    auto backing = std::const_pointer_cast< args::backing >( _backing );
+    ret._begin = ret._index = _views - backing->views.data();
+    ret._end = ret._begin + _size;
+    ret._backing = std::move( backing );
+    return ret;
+}
+
 // Operators implementation
 
+namespace detail {
+
+    /* Whether the standard library has std::from_chars for floating point.
+     * Where it does not, floating point types are parsed with streams.
+     */
+#if defined(__cpp_lib_to_chars)
+    inline constexpr bool from_chars_floating = true;
+#else
+    inline constexpr bool from_chars_floating = false;
+#endif
+
+    /* Whether operator>>( args&, T& ) will use std::from_chars for T.
+     * Character types are excluded because streams read them as characters.
+     */
+    template< typename T >
+    inline constexpr bool from_chars_parsable =
+        ( std::is_integral_v<T> ||
+          ( std::is_floating_point_v<T> && from_chars_floating ) ) &&
+        !std::is_same_v<T, bool> &&
+        !std::is_same_v<T, char> &&
+        !std::is_same_v<T, signed char> &&
+        !std::is_same_v<T, unsigned char> &&
+        !std::is_same_v<T, wchar_t> &&
+        !std::is_same_v<T, char16_t> &&
+        !std::is_same_v<T, char32_t>;
+
+    /* Outcome of parse_number. 'rest' points to the first unparsed character. */
+    enum class parse_status { ok, invalid, out_of_range, partial };
+
+    struct parse_result {
+        parse_status status;
+        const char * rest;
+    };
+
+    /* Decimal integer parsing.
+     *
+     * Eight digits are validated and converted at a time
+     * with 64-bit arithmetic ("SWAR"), instead of one digit per iteration.
+     * This is only done on little-endian targets; elsewhere,
+     * and for the tail of the string, a digit-at-a-time loop is used.
+     */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ \
+        || defined(_M_X64) || defined(_M_IX86) || defined(_M_ARM64)
+    inline constexpr bool swar_digits = true;
+#else
+    inline constexpr bool swar_digits = false;
+#endif
+
+    /* Whether all of the eight bytes in 'chunk' are in '0'...'9'. */
+    inline bool all_digits( std::uint64_t chunk ) {
+        return ( ( chunk & 0xF0F0F0F0F0F0F0F0 ) |
+            ( ( ( chunk + 0x0606060606060606 ) & 0xF0F0F0F0F0F0F0F0 ) >> 4 ) )
+            == 0x3333333333333333;
+    }
+
+    /* Value of the eight digits in 'chunk'; the first digit is the lowest byte. */
+    inline std::uint32_t eight_digits( std::uint64_t chunk ) {
+        chunk -= 0x3030303030303030;
+        chunk = chunk * 10 + ( chunk >> 8 );
+        chunk = ( ( ( chunk & 0x000000FF000000FF ) * ( 100 + ( 1000000ull << 32 ) ) ) +
+            ( ( ( chunk >> 16 ) & 0x000000FF000000FF ) * ( 1 + ( 10000ull << 32 ) ) ) )
+            >> 32;
+        return static_cast< std::uint32_t >( chunk );
+    }
+
+    /* Reads the digits at the beginning of [first, last) into 'value'
+     * and sets 'end' past the last digit.
+     * Returns false if the value does not fit in 64 bits.
+     */
+    inline bool parse_digits(
+        const char * first,
+        const char * last,
+        std::uint64_t & value,
+        const char * & end
+    ) {
+        std::uint64_t v = 0;
+        const char * p = first;
+
+        /* 19 digits always fit in 64 bits, so no overflow checks here. */
+        if constexpr( swar_digits ) {
+            while( last - p >= 8 && p - first + 8 <= 19 ) {
+                std::uint64_t chunk;
+                std::memcpy( &chunk, p, 8 );
+                if( !all_digits( chunk ) )
+                    break;
+                v = v * 100000000 + eight_digits( chunk );
+                p += 8;
+            }
+        }
+        while( p != last && p - first < 19 && unsigned( *p - '0' ) < 10 )
+            v = v * 10 + unsigned( *p++ - '0' );
+
+        /* Further digits may still fit: a 20th digit, or leading zeros. */
+        bool overflow = false;
+        for( ; p != last && unsigned( *p - '0' ) < 10; ++p ) {
+            unsigned digit = *p - '0';
+            if( overflow || v > ( std::numeric_limits<std::uint64_t>::max() - digit ) / 10 )
+                overflow = true;
+            else
+                v = v * 10 + digit;
+        }
+        end = p;
+        value = v;
+        return !overflow;
+    }
+
+    /* Same as std::from_chars( first, last, t ) for integral T,
+     * for types of at most 64 bits.
+     */
+    template< typename T >
+    std::from_chars_result parse_integer( const char * first, const char * last, T & t ) {
+        static_assert( sizeof( T ) <= sizeof( std::uint64_t ) );
+        bool negative = false;
+        const char * digits = first;
+        if constexpr( std::is_signed_v<T> ) {
+            if( digits != last && *digits == '-' ) {
+                negative = true;
+                ++digits;
+            }
+        }
+        if( digits == last || unsigned( *digits - '0' ) >= 10 )
+            return { first, std::errc::invalid_argument };
+
+        std::uint64_t value;
+        const char * end;
+        if( !parse_digits( digits, last, value, end ) )
+            return { end, std::errc::result_out_of_range };
+
+        using U = std::make_unsigned_t<T>;
+        U max = std::numeric_limits<T>::max();
+        if( negative ) {
+            if( value > std::uint64_t( max ) + 1 )
+                return { end, std::errc::result_out_of_range };
+            t = static_cast< T >( U( 0 ) - static_cast< U >( value ) );
+        }
+        else {
+            if( value > max )
+                return { end, std::errc::result_out_of_range };
+            t = static_cast< T >( value );
+        }
+        return { end, std::errc() };
+    }
+
+    /* Whether the decimal floating point number in [first, last),
+     * which std::from_chars found to be out of range,
+     * is too close to zero rather than too large.
+     *
+     * The number is below 1 exactly when its decimal order of magnitude
+     * (digits before the point, minus zeros after it, plus the exponent)
+     * is not positive. This does not depend on the locale, unlike strtod.
+     */
+    inline bool underflows( const char * first, const char * last ) {
+        auto digit = []( char c ) { return unsigned( c - '0' ) < 10; };
+        if( first != last && *first == '-' )
+            ++first;
+
+        long long order = 0;
+        bool nonzero = false;
+        for( ; first != last && digit( *first ); ++first )
+            if( nonzero || *first != '0' ) {
+                nonzero = true;
+                order++;
+            }
+        if( first != last && *first == '.' )
+            for( ++first; first != last && digit( *first ); ++first )
+                if( !nonzero ) {
+                    if( *first == '0' )
+                        order--;
+                    else
+                        nonzero = true;
+                }
+
+        if( first != last && ( *first == 'e' || *first == 'E' ) ) {
+            ++first;
+            bool negative = first != last && *first == '-';
+            if( first != last && ( *first == '-' || *first == '+' ) )
+                ++first;
+            long long exponent = 0;
+            for( ; first != last && digit( *first ); ++first )
+                if( exponent < 1000000000 )
+                    exponent = exponent * 10 + ( *first - '0' );
+            order += negative ? -exponent : exponent;
+        }
+        return order <= 0;
+    }
+
+    /* Parses 'str' into 't' the way a std::istream would,
+     * but without writing anything; see report_parse.
+     */
+    template< typename T >
+    parse_result parse_number( std::string_view str, T & t ) {
+        const char * first = str.data();
+        const char * last = str.data() + str.size();
+
+        /* Streams skip leading whitespace and accept a leading plus sign. */
+        constexpr std::string_view space = " \t\n\v\f\r";
+        while( first != last && space.find( *first ) != space.npos )
+            ++first;
+        if( first != last && *first == '+' && last - first > 1 && first[1] != '-' )
+            ++first;
+
+        std::from_chars_result parsed;
+        if constexpr( std::is_integral_v<T> && sizeof( T ) <= sizeof( std::uint64_t ) )
+            parsed = parse_integer( first, last, t );
+        else
+            parsed = std::from_chars( first, last, t );
+        auto [ptr, ec] = parsed;
+        if( ec == std::errc::invalid_argument ) {
+            t = 0;
+            return { parse_status::invalid, first };
+        }
+        if constexpr( std::is_floating_point_v<T> ) {
+            if( ec == std::errc::result_out_of_range && underflows( first, ptr ) ) {
+                /* Streams read numbers too close to zero as zero, without error. */
+                t = *first == '-' ? -T( 0 ) : T( 0 );
+                ec = std::errc();
+            }
+        }
+        if( ec == std::errc::result_out_of_range ) {
+            /* Streams clamp the value in this case. */
+            if( *first == '-' )
+                t = std::numeric_limits<T>::lowest();
+            else
+                t = std::numeric_limits<T>::max();
+            return { parse_status::out_of_range, first };
+        }
+        if( ptr != last )
+            return { parse_status::partial, ptr };
+        return { parse_status::ok, ptr };
+    }
+
+    /* Reports the outcome of parse_number on the argument 'str',
+     * at position 'index' of 'a'.
+     */
+    inline void report_parse(
+        args & a,
+        std::size_t index,
+        std::string_view str,
+        parse_result result
+    ) {
+        if( result.status == parse_status::ok )
+            return;
+        diagnostic d{ diagnostic_kind::could_not_parse, index, str };
+        if( result.status == parse_status::partial ) {
+            d.kind = diagnostic_kind::partially_parsed;
+            d.context = str.substr( result.rest - str.data() );
+        }
+        a.report( d );
+    }
+
+    /* Parses 'str' into 't' like operator>>, without reporting anything. */
+    template< typename T >
+    parse_result parse_value( std::string_view str, T & t ) {
+        if constexpr( from_chars_parsable<T> )
+            return parse_number( str, t );
+        else {
+            std::stringstream stream{ std::string( str ) };
+            stream >> t;
+            if( !stream )
+                return { parse_status::invalid, str.data() };
+            if( !stream.eof() )
+                return { parse_status::partial, str.data() + stream.tellg() };
+            return { parse_status::ok, str.data() + str.size() };
+        }
+    }
+
+    /* Parses views[0], ..., views[count-1] into out[0], ..., out[count-1]
+     * and appends to 'failed' the positions that could not be parsed,
+     * each plus 'offset'.
+     */
+    template< typename T >
+    void parse_values(
+        const std::string_view * views,
+        std::size_t count,
+        T * out,
+        std::size_t offset,
+        std::pmr::vector< std::size_t > & failed
+    ) {
+        /* Failures are rare; remember only their positions in the hot loop. */
+        for( std::size_t i = 0; i < count; ++i )
+            if( parse_value( views[i], out[i] ).status != parse_status::ok )
+                failed.push_back( offset + i );
+    }
+
+    /* Same as parse_values, with the work split among up to 'threads' threads.
+     *
+     * Only the calling thread allocates, from the resource of 'failed',
+     * which need not be thread-safe.
+     */
+    template< typename T >
+    void parse_values_parallel(
+        const std::string_view * views,
+        std::size_t count,
+        T * out,
+        unsigned threads,
+        std::pmr::vector< std::size_t > & failed
+    ) {
+        /* Below this many arguments per thread,
+         * starting the thread costs more than parsing. */
+        constexpr std::size_t min_chunk = 1 << 12;
+
+        if( threads == 0 )
+            threads = std::max( 1u, std::thread::hardware_concurrency() );
+        std::size_t chunks = std::min< std::size_t >( threads, count / min_chunk );
+        if( chunks <= 1 ) {
+            parse_values( views, count, out, 0, failed );
+            return;
+        }
+
+        /* Each chunk remembers its first few failures in a fixed buffer,
+         * so that the workers never allocate.
+         * The failures after those are found again by the calling thread. */
+        struct chunk_failures {
+            std::array< std::size_t, 16 > positions;
+            std::size_t count = 0;
+        };
+
+        /* Chunk 0 is parsed by the calling thread.
+         * The lists of failures are concatenated in order,
+         * so the result does not depend on timing. */
+        std::pmr::memory_resource * resource = failed.get_allocator().resource();
+        std::pmr::vector< chunk_failures > chunk_failed( chunks, resource );
+        std::pmr::vector< std::exception_ptr > errors( chunks, resource );
+        std::pmr::vector< std::thread > workers( resource );
+        workers.reserve( chunks - 1 );
+
+        auto bounds = [&]( std::size_t chunk ) {
+            return std::make_pair( count * chunk / chunks, count * (chunk + 1) / chunks );
+        };
+        auto work = [&]( std::size_t chunk ) {
+            auto [begin, end] = bounds( chunk );
+            chunk_failures & list = chunk_failed[chunk];
+            try {
+                for( std::size_t i = begin; i < end; ++i )
+                    if( parse_value( views[i], out[i] ).status != parse_status::ok ) {
+                        if( list.count < list.positions.size() )
+                            list.positions[list.count] = i;
+                        list.count++;
+                    }
+            }
+            catch( ... ) {
+                errors[chunk] = std::current_exception();
+            }
+        };
+        try {
+            for( std::size_t chunk = 1; chunk < chunks; chunk++ )
+                workers.emplace_back( work, chunk );
+        }
+        catch( ... ) {
+            /* Could not start every thread; parse the rest here. */
+            for( std::size_t chunk = workers.size() + 1; chunk < chunks; chunk++ )
+                work( chunk );
+        }
+        work( 0 );
+        for( std::thread & worker : workers )
+            worker.join();
+
+        for( std::exception_ptr & error : errors )
+            if( error )
+                std::rethrow_exception( error );
+        for( std::size_t chunk = 0; chunk < chunks; chunk++ ) {
+            const chunk_failures & list = chunk_failed[chunk];
+            std::size_t kept = std::min( list.count, list.positions.size() );
+            failed.insert( failed.end(),
+                list.positions.begin(), list.positions.begin() + kept );
+            if( list.count > kept ) {
+                /* Parsing again writes the same values. */
+                std::size_t begin = list.positions[kept - 1] + 1;
+                std::size_t end = bounds( chunk ).second;
+                parse_values( views + begin, end - begin, out + begin, begin, failed );
+            }
+        }
+    }
+
+    /* Reports at once the failures found by parse_values,
+     * where views[0] is at position 'index' of 'a'.
+     */
+    template< typename T >
+    void report_values(
+        args & a,
+        std::size_t index,
+        const std::string_view * views,
+        std::size_t count,
+        const std::pmr::vector< std::size_t > & failed
+    ) {
+        if( failed.empty() )
+            return;
+
+        cmdline::diagnostics report( a.resource() );
+        diagnostic header{ diagnostic_kind::extract_failed, index };
+        header.count = failed.size();
+        header.total = count;
+        report.push_back( header );
+        for( std::size_t i : failed ) {
+            T ignored;
+            std::string_view str = views[i];
+            parse_result result = parse_value( str, ignored );
+            diagnostic d{ diagnostic_kind::could_not_parse, index + i, str };
+            if( result.status == parse_status::partial ) {
+                d.kind = diagnostic_kind::partially_parsed;
+                d.context = str.substr( result.rest - str.data() );
+            }
+            report.push_back( d );
+        }
+        a.report( report );
+    }
+
+} // namespace detail
+
 template <typename T>
 args & operator>>( args & a, T & t ) {
-    std::stringstream stream( a.next() );
-    stream >> t;
-    if( !stream ) {
-        a.log() << "Error: could not parse " << stream.str() << ".\n";
-        return a;
-    }
-    if( !stream.eof() ) {
-        a.log() << "Warning: partially parsed string\n"
-            << "Unparsed bit: '" << stream.str().substr(stream.tellg())
-            << "'\n";
-        return a;
-    }
+    std::size_t index = a.total_size() - a.size();
+    std::string_view str = a.next_view();
+    detail::report_parse( a, index, str, detail::parse_value( str, t ) );
     return a;
 }
 
+template< typename T >
+std::vector< T > args::extract( std::size_t count ) {
+    static_assert( !std::is_same_v< T, bool >,
+        "std::vector< bool > has no data(); use extract( bool *, count )." );
+    if( count > size() )
+        throw std::out_of_range( "Not enough arguments to extract." );
+    std::vector< T > ret( count );
+    extract( ret.data(), count );
+    return ret;
+}
+
+template< typename T >
+void args::extract( T * out, std::size_t count ) {
+    if( count > size() )
+        throw std::out_of_range( "Not enough arguments to extract." );
+    /* begin() copes with an object that has no storage yet. */
+    const std::string_view * views = begin();
+    std::pmr::vector< std::size_t > failed( resource() );
+    detail::parse_values( views, count, out, 0, failed );
+    detail::report_values< T >( *this, _index - _begin, views, count, failed );
+    _index += count;
+}
+
+template< typename T >
+std::vector< T > args::extract( std::size_t count, parallel_t, unsigned threads ) {
+    static_assert( !std::is_same_v< T, bool >,
+        "std::vector< bool > has no data(); use extract( bool *, count )." );
+    if( count > size() )
+        throw std::out_of_range( "Not enough arguments to extract." );
+    std::vector< T > ret( count );
+    extract( ret.data(), count, parallel, threads );
+    return ret;
+}
+
+template< typename T >
+void args::extract( T * out, std::size_t count, parallel_t, unsigned threads ) {
+    if( count > size() )
+        throw std::out_of_range( "Not enough arguments to extract." );
+    const std::string_view * views = begin();
+    std::pmr::vector< std::size_t > failed( resource() );
+    detail::parse_values_parallel( views, count, out, threads, failed );
+    detail::report_values< T >( *this, _index - _begin, views, count, failed );
+    _index += count;
+}
+
+template< typename T, typename Predicate >
+std::vector< T > args::extract_until( Predicate && predicate ) {
+    return extract< T >( find_until( _index, predicate ) - _index );
+}
+
+namespace detail {
+
+    /* a < b, without the surprises of the usual arithmetic conversions
+     * when a and b are integers of different signedness
+     * (like C++20's std::cmp_less).
+     */
+    template< typename A, typename B >
+    constexpr bool less( const A & a, const B & b ) {
+        if constexpr( std::is_integral_v<A> && std::is_integral_v<B> &&
+                std::is_signed_v<A> != std::is_signed_v<B> ) {
+            if constexpr( std::is_signed_v<A> )
+                return a < 0 || std::make_unsigned_t<A>( a ) < b;
+            else
+                return b >= 0 && a < std::make_unsigned_t<B>( b );
+        }
+        else
+            return a < b;
+    }
+
+    /* Number of characters in the decimal representation of Value. */
+    template< auto Value >
+    constexpr std::size_t integer_length() {
+        auto v = Value;
+        std::size_t length = v < 0 ? 2 : 1;
+        while( v /= 10 )
+            length++;
+        return length;
+    }
+
+    /* Decimal representation of Value, built at compile time,
+     * for the diagnostics of static_range_parser.
+     */
+    template< auto Value >
+    struct integer_text {
+        static constexpr std::size_t size = integer_length< Value >();
+
+        static constexpr std::array< char, size > build() {
+            std::array< char, size > ret{};
+            auto v = Value;
+            std::size_t i = size;
+            do {
+                int digit = v % 10;
+                ret[--i] = char( '0' + ( digit < 0 ? -digit : digit ) );
+                v /= 10;
+            } while( v != 0 );
+            if( Value < 0 )
+                ret[--i] = '-';
+            return ret;
+        }
+
+        static constexpr std::array< char, size > text = build();
+
+        static constexpr std::string_view view() {
+            return std::string_view( text.data(), text.size() );
+        }
+    };
+
+    /* Reports that the number just read from 'a' violates 'bound'.
+     * Arithmetic bounds are kept as numbers; others are formatted now.
+     */
+    template< typename Bound >
+    void report_range( args & a, diagnostic_kind kind, const Bound & bound ) {
+        /* The number is at peek(-1) now, and the option name at peek(-2). */
+        std::size_t index = a.total_size() - a.size() - 1;
+        diagnostic d{ kind, index, a.peek_view(-1) };
+        if( index > 0 )
+            d.context = a.peek_view(-2);
+
+        if constexpr( std::is_integral_v< Bound > && std::is_signed_v< Bound > )
+            d.bound = static_cast< long long >( bound );
+        else if constexpr( std::is_integral_v< Bound > )
+            d.bound = static_cast< unsigned long long >( bound );
+        else if constexpr( std::is_floating_point_v< Bound > )
+            d.bound = static_cast< long double >( bound );
+        else if constexpr( std::is_same_v< Bound, std::string_view > )
+            d.bound = bound;
+        else {
+            std::ostringstream text;
+            text << bound;
+            std::string str = text.str();
+            d.bound = std::string_view( str );
+            a.report( d );
+            return;
+        }
+        a.report( d );
+    }
+
+} // namespace detail
+
 /* We must declare this operator as taking a rvalue reference
  * instead of a normal reference
  * because args::range return a range_parser by value,
  * thus making it a rvalue, not a lvalue. */
-template< typename Number >
-void operator>>( range_parser && range, Number & n ) {
-    std::string error;
-    if( range._args.size() < range._args.total_size() )
-        error = "Error: argument to " + range._args.peek(-1);
-    else
-        error = "Error: number";
+template< typename Number, typename Min, typename Max >
+void operator>>( range_parser< Min, Max > && range, Number & n ) {
+    range._args >> n;
+
+    if( detail::less( n, range.min ) )
+        detail::report_range( range._args, diagnostic_kind::below_minimum, range.min );
+    if( detail::less( range.min, range.max ) && detail::less( range.max, n ) )
+        detail::report_range( range._args, diagnostic_kind::above_maximum, range.max );
+}
 
+template< typename Number, auto Min, auto Max >
+void operator>>( static_range_parser< Min, Max > && range, Number & n ) {
     range._args >> n;
-    if( n < range.min ) {
-        range._args.log() << error << " must be greater than "
-                << (Number) range.min << ".\n";
-    }
-    if( range.min < range.max && range.max < n ) {
-        range._args.log() << error << " must be smaller than "
-                << (Number) range.max << ".\n";
-    }
+
+    /* For arithmetic types, skip the checks that no value of Number can fail. */
+    constexpr bool check_min = !std::is_arithmetic_v< Number > ||
+        detail::less( std::numeric_limits< Number >::lowest(), Min );
+    constexpr bool check_max = detail::less( Min, Max ) &&
+        ( !std::is_arithmetic_v< Number > ||
+          detail::less( Max, std::numeric_limits< Number >::max() ) );
+
+    if constexpr( check_min )
+        if( detail::less( n, Min ) )
+            detail::report_range( range._args, diagnostic_kind::below_minimum,
+                detail::integer_text< Min >::view() );
+    if constexpr( check_max )
+        if( detail::less( Max, n ) )
+            detail::report_range( range._args, diagnostic_kind::above_maximum,
+                detail::integer_text< Max >::view() );
 }
 
 } // namespace cmdline
 
+#if __cplusplus >= 202002L
+template<>
+inline constexpr bool std::ranges::enable_borrowed_range< cmdline::arg_range > = true;
+template<>
+inline constexpr bool std::ranges::enable_view< cmdline::arg_range > = true;
+#endif
+
 #endif // CMDLINE_ARGV_H
@@ -0,0 +1,680 @@
+#ifndef CMDLINE_OPTIONS_H
+#define CMDLINE_OPTIONS_H
+
+/* Declarative option table built on top of cmdline::args.
+ *
+ * Instead of writing chains of
+ *  if( args.peek() == "--val" ) ... else if( args.peek() == "-v" ) ...
+ * the options are described once, with their names, aliases,
+ * number of arguments and where the parsed values should go:
+ *
+ *  bool verbose = false;
+ *  int level = 0;
+ *  cmdline::options opts;
+ *  opts.flag( {"-v", "--verbose"}, verbose, "Print more output." )
+ *      .value( {"-l", "--level"}, level, 2, 14, "Level between 2 and 14." );
+ *  opts.parse( args );
+ *
+ * The names are compiled into a perfect hash table,
+ * so recognizing an argument costs one hash and one string comparison
+ * regardless of the number of options.
+ *
+ * If the options are known at compile time,
+ * cmdline::static_options builds the same hash table
+ * and the help text as constant expressions;
+ * see below.
+ */
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "args.hpp"
+
+namespace cmdline {
+
+namespace detail {
+
+    inline constexpr std::size_t npos = -1;
+
+    /* Rehashes h with the given seed (the finalizer of MurmurHash3). */
+    constexpr std::uint64_t mix( std::uint64_t h, std::uint64_t seed ) {
+        h ^= seed * 0x9e3779b97f4a7c15ull;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    /* FNV-1a, finalized with mix so that the high bits are usable too. */
+    constexpr std::uint64_t hash( std::string_view str ) {
+        std::uint64_t h = 0xcbf29ce484222325ull;
+        for( char c : str ) {
+            h ^= (unsigned char) c;
+            h *= 0x100000001b3ull;
+        }
+        return mix( h, 0 );
+    }
+
+    constexpr std::size_t power_of_two_at_least( std::size_t n ) {
+        std::size_t p = 1;
+        while( p < n )
+            p *= 2;
+        return p;
+    }
+
+    /* Dimensions of the perfect hash table for n keys. */
+    constexpr std::size_t hash_buckets( std::size_t n ) {
+        return power_of_two_at_least( n / 4 + 1 );
+    }
+    constexpr std::size_t hash_slots( std::size_t n ) {
+        return power_of_two_at_least( 2 * n );
+    }
+
+    /* Builds a perfect hash table ("hash and displace") for the n keys
+     * whose hashes are given.
+     *
+     * Each key goes to bucket (hash >> 32) & (buckets - 1);
+     * the keys of bucket b are placed at slot
+     *  mix( hash, seeds[b] ) & (slots - 1).
+     * The buckets are processed from the largest to the smallest,
+     * and for each one the first seed that sends its keys
+     * to distinct empty slots is chosen.
+     * 'table' receives, for each slot, the index of its key or npos.
+     *
+     * 'buckets' and 'slots' must be the values of hash_buckets(n)
+     * and hash_slots(n), and 'scratch' must have room for buckets + n values.
+     *
+     * Returns false if some seeds could not be found,
+     * which only happens if two keys have the same hash.
+     *
+     * This function is constexpr so that static_options
+     * can build its table at compile time.
+     */
+    constexpr bool build_perfect_hash(
+        const std::uint64_t * hashes, std::size_t n,
+        std::uint64_t * seeds, std::size_t buckets,
+        std::size_t * table, std::size_t slots,
+        std::size_t * scratch
+    ) {
+        /* Counting sort of the keys by bucket.
+         * Afterwards, the keys of bucket b are
+         * order[start[b]] to order[start[b+1] - 1]. */
+        std::size_t * start = scratch;
+        std::size_t * order = scratch + buckets;
+        for( std::size_t b = 0; b < buckets; b++ )
+            start[b] = 0;
+        std::size_t largest = 0;
+        for( std::size_t i = 0; i < n; i++ ) {
+            std::size_t & count = start[hashes[i] >> 32 & (buckets - 1)];
+            if( ++count > largest )
+                largest = count;
+        }
+        for( std::size_t b = 0, sum = 0; b < buckets; b++ ) {
+            std::size_t count = start[b];
+            start[b] = sum;
+            sum += count;
+        }
+        for( std::size_t i = 0; i < n; i++ )
+            order[start[hashes[i] >> 32 & (buckets - 1)]++] = i;
+        /* Now start[b] is the end of bucket b. */
+
+        for( std::size_t i = 0; i < slots; i++ )
+            table[i] = npos;
+        for( std::size_t b = 0; b < buckets; b++ )
+            seeds[b] = 0;
+
+        for( std::size_t size = largest; size > 0; size-- )
+        for( std::size_t b = 0; b < buckets; b++ ) {
+            std::size_t end = start[b];
+            std::size_t begin = b == 0 ? 0 : start[b-1];
+            if( end - begin != size )
+                continue;
+
+            for( std::uint64_t seed = 0; ; seed++ ) {
+                if( seed == 1u << 20 )
+                    return false;
+
+                std::size_t placed = begin;
+                for( ; placed < end; placed++ ) {
+                    std::size_t key = order[placed];
+                    std::size_t slot = mix( hashes[key], seed ) & (slots - 1);
+                    if( table[slot] != npos )
+                        break;
+                    table[slot] = key;
+                }
+                if( placed == end ) {
+                    seeds[b] = seed;
+                    break;
+                }
+                /* Undo the partial placement. */
+                for( std::size_t i = begin; i < placed; i++ )
+                    table[mix( hashes[order[i]], seed ) & (slots - 1)] = npos;
+            }
+        }
+        return true;
+    }
+
+    /* Returns the slot of the perfect hash table where h might be. */
+    constexpr std::size_t perfect_hash_slot(
+        std::uint64_t h,
+        const std::uint64_t * seeds, std::size_t buckets,
+        std::size_t slots
+    ) {
+        return mix( h, seeds[h >> 32 & (buckets - 1)] ) & (slots - 1);
+    }
+
+    /* Calls f( name ) for every name in the list "name1, name2, ...". */
+    template< typename F >
+    constexpr void for_each_name( std::string_view names, F && f ) {
+        while( !names.empty() ) {
+            std::size_t comma = names.find( ", " );
+            f( names.substr( 0, comma ) );
+            if( comma == names.npos )
+                break;
+            names.remove_prefix( comma + 2 );
+        }
+    }
+
+    /* The loop of options::parse and static_options::parse. */
+    template< typename ParseOne >
+    void parse_options( args & args, ParseOne parse_one ) {
+        while( auto arg = args.try_peek() ) {
+            if( parse_one() )
+                continue;
+            if( *arg == "--" ) {
+                args.shift();
+                return;
+            }
+            if( arg->size() < 2 || (*arg)[0] != '-' )
+                return;
+            args.report( diagnostic{ diagnostic_kind::unknown_option,
+                args.total_size() - args.size(), *arg } );
+            args.shift();
+        }
+    }
+
+    /* Consumes the option name and checks that there are enough arguments.
+     * If there are not, reports the error and consumes everything. */
+    inline bool check_arity( args & args, std::size_t arity ) {
+        std::size_t index = args.total_size() - args.size();
+        std::string_view name = args.next_view();
+        if( args.size() >= arity )
+            return true;
+
+        diagnostic d{ diagnostic_kind::missing_option_argument, index, name };
+        d.count = arity;
+        args.report( d );
+        while( args.size() > 0 )
+            args.shift();
+        return false;
+    }
+
+} // namespace detail
+
+    class options {
+        struct option {
+            std::vector< std::string > names;
+            std::size_t arity;
+            std::string help;
+            std::function< void( args & ) > handler;
+        };
+
+        std::vector< option > _options;
+
+        /* Perfect hash table from option names to their indices;
+         * see detail::build_perfect_hash.
+         * _slots holds indices into _names, or npos for empty slots.
+         * Each entry of _names is the pair ( option index, name index ),
+         * so copies of this object need not fix any pointers. */
+        std::vector< std::pair< std::size_t, std::size_t > > _names;
+        std::vector< std::uint64_t > _seeds;
+        std::vector< std::size_t > _slots;
+        bool _compiled;
+
+        static constexpr std::size_t npos = detail::npos;
+
+    public:
+        /* Constructs an empty option table. */
+        options();
+
+        /* Adds an option that takes no arguments
+         * and sets 'target' to true when found.
+         */
+        options & flag(
+            std::initializer_list< std::string_view > names,
+            bool & target,
+            std::string_view help = ""
+        );
+
+        /* Adds an option that takes one argument,
+         * parsed into 'target' with operator>>( args&, T& ).
+         */
+        template< typename T >
+        options & value(
+            std::initializer_list< std::string_view > names,
+            T & target,
+            std::string_view help = ""
+        );
+
+        /* Same as above, but the value is also checked to be within
+         * [min, max], using args::range.
+         */
+        template< typename T, typename Min, typename Max >
+        options & value(
+            std::initializer_list< std::string_view > names,
+            T & target,
+            Min min,
+            Max max,
+            std::string_view help = ""
+        );
+
+        /* Adds an option that takes 'arity' arguments.
+         * When the option is found, 'handler' is called
+         * with the argument vector positioned after the option name;
+         * the handler is expected to consume exactly 'arity' arguments.
+         */
+        options & handler(
+            std::initializer_list< std::string_view > names,
+            std::size_t arity,
+            std::function< void( args & ) > handler,
+            std::string_view help = ""
+        );
+
+        /* If args.peek() is one of the options,
+         * consumes it along with its arguments and returns true.
+         * Otherwise, returns false and leaves args untouched.
+         *
+         * If there are less than 'arity' arguments after the option,
+         * an error is reported with args.report(),
+         * the remaining arguments are consumed and true is returned.
+         */
+        bool parse_one( args & args );
+
+        /* Calls parse_one until the next argument is not an option.
+         *
+         * Unknown arguments that begin with '-' are reported with args.report()
+         * and skipped. Parsing stops at the first argument that does not
+         * begin with '-' (or is exactly "-"), so that positional arguments
+         * and subcommands are left in args.
+         * An argument "--" also stops the parsing, and is consumed.
+         */
+        void parse( args & args );
+
+        /* Writes a description of every option to 'os',
+         * one line per option, aligned in two columns.
+         */
+        void help( std::ostream & os ) const;
+
+    private:
+        options & add( std::initializer_list< std::string_view > names,
+            std::size_t arity, std::string_view help,
+            std::function< void( args & ) > handler );
+
+        /* Returns the index of the option named 'name', or npos. */
+        std::size_t find( std::string_view name );
+
+        /* Builds the perfect hash table. */
+        void compile();
+    };
+
+    /* Description of an option known at compile time;
+     * see static_options below.
+     *
+     * 'names' is the list of names of the option, separated by ", ",
+     * like "-v, --verbose".
+     * When the option is found, 'handler' is called with the argument vector
+     * positioned after the option name, and with the context object
+     * given to static_options::parse.
+     */
+    template< typename Context >
+    struct static_option {
+        std::string_view names;
+        std::size_t arity;
+        void (* handler)( args &, Context & );
+        std::string_view help;
+    };
+
+    /* Option table whose perfect hash table and help text
+     * are computed entirely at compile time,
+     * so using it costs no initialization at run time.
+     *
+     * 'Specs' must be a constexpr array of static_option<Context>
+     * with static storage duration.
+     * Use like this:
+     *
+     *  struct config { bool verbose = false; int level = 0; };
+     *  constexpr cmdline::static_option<config> specs[] = {
+     *      { "-v, --verbose", 0,
+     *          []( cmdline::args &, config & c ) { c.verbose = true; },
+     *          "Print more output." },
+     *      { "-l, --level", 1,
+     *          []( cmdline::args & a, config & c ) { a.range( 2, 14 ) >> c.level; },
+     *          "Level between 2 and 14." },
+     *  };
+     *  using opts = cmdline::static_options< specs >;
+     *
+     *  config c;
+     *  opts::parse( args, c );
+     *
+     * The behavior of parse_one, parse and help
+     * is the same as for cmdline::options.
+     * Repeated names are rejected at compile time.
+     */
+    template< const auto & Specs >
+    class static_options {
+        using spec_type = std::remove_const_t<
+            std::remove_reference_t< decltype( Specs[0] ) > >;
+
+        template< typename T >
+        struct context_of;
+        template< typename C >
+        struct context_of< static_option<C> > { using type = C; };
+
+    public:
+        using context_type = typename context_of< spec_type >::type;
+
+    private:
+        static constexpr std::size_t option_count = std::size( Specs );
+
+        static constexpr std::size_t count_names() {
+            std::size_t count = 0;
+            for( const spec_type & spec : Specs )
+                detail::for_each_name( spec.names,
+                    [&count]( std::string_view ) { count++; } );
+            return count;
+        }
+
+        static constexpr std::size_t name_count = count_names();
+        static constexpr std::size_t buckets = detail::hash_buckets( name_count );
+        static constexpr std::size_t slots = detail::hash_slots( name_count );
+
+        struct hash_table {
+            std::array< std::string_view, name_count > names{};
+            std::array< std::size_t, name_count > option{};
+            std::array< std::uint64_t, buckets > seeds{};
+            std::array< std::size_t, slots > table{};
+        };
+
+        static constexpr hash_table build_table() {
+            hash_table ret{};
+            std::array< std::uint64_t, name_count > hashes{};
+            std::size_t n = 0;
+            for( std::size_t i = 0; i < option_count; i++ )
+                detail::for_each_name( Specs[i].names, [&]( std::string_view name ) {
+                    for( std::size_t j = 0; j < n; j++ )
+                        if( ret.names[j] == name )
+                            throw std::logic_error( "Repeated option name." );
+                    ret.names[n] = name;
+                    ret.option[n] = i;
+                    hashes[n] = detail::hash( name );
+                    n++;
+                });
+
+            std::array< std::size_t, buckets + name_count > scratch{};
+            if( !detail::build_perfect_hash( hashes.data(), name_count,
+                    ret.seeds.data(), buckets, ret.table.data(), slots,
+                    scratch.data() ) )
+                throw std::logic_error( "Could not build the perfect hash." );
+            return ret;
+        }
+
+        static constexpr hash_table _table = build_table();
+
+        /* Help text: one line per option, in two aligned columns. */
+        static constexpr std::size_t names_width() {
+            std::size_t width = 0;
+            for( const spec_type & spec : Specs )
+                if( spec.names.size() > width )
+                    width = spec.names.size();
+            return width;
+        }
+
+        static constexpr std::size_t help_size() {
+            std::size_t size = 0;
+            for( const spec_type & spec : Specs ) {
+                size += 2 + spec.names.size() + 1;
+                if( !spec.help.empty() )
+                    size += names_width() - spec.names.size() + 2 + spec.help.size();
+            }
+            return size;
+        }
+
+        static constexpr std::array< char, help_size() > build_help() {
+            std::array< char, help_size() > ret{};
+            std::size_t i = 0;
+            auto append = [&]( std::string_view str ) {
+                for( char c : str )
+                    ret[i++] = c;
+            };
+            for( const spec_type & spec : Specs ) {
+                append( "  " );
+                append( spec.names );
+                if( !spec.help.empty() ) {
+                    for( std::size_t j = spec.names.size(); j < names_width() + 2; j++ )
+                        ret[i++] = ' ';
+                    append( spec.help );
+                }
+                ret[i++] = '\n';
+            }
+            return ret;
+        }
+
+        static constexpr std::array< char, help_size() > _help = build_help();
+
+    public:
+        /* Returns the index in Specs of the option named 'name',
+         * or detail::npos if there is none.
+         */
+        static constexpr std::size_t find( std::string_view name );
+
+        static bool parse_one( args & args, context_type & context );
+        static void parse( args & args, context_type & context );
+
+        /* The text written by help(). */
+        static constexpr std::string_view help_text();
+        static void help( std::ostream & os );
+    };
+
+// Class implementation
+
+inline options::options() :
+    _compiled( false )
+{}
+
+inline options & options::flag(
+    std::initializer_list< std::string_view > names,
+    bool & target,
+    std::string_view help
+) {
+    return add( names, 0, help, [&target]( args & ) { target = true; } );
+}
+
+template< typename T >
+options & options::value(
+    std::initializer_list< std::string_view > names,
+    T & target,
+    std::string_view help
+) {
+    return add( names, 1, help, [&target]( args & a ) { a >> target; } );
+}
+
+template< typename T, typename Min, typename Max >
+options & options::value(
+    std::initializer_list< std::string_view > names,
+    T & target,
+    Min min,
+    Max max,
+    std::string_view help
+) {
+    return add( names, 1, help, [&target, min, max]( args & a ) {
+        a.range( min, max ) >> target;
+    });
+}
+
+inline options & options::handler(
+    std::initializer_list< std::string_view > names,
+    std::size_t arity,
+    std::function< void( args & ) > handler,
+    std::string_view help
+) {
+    return add( names, arity, help, std::move(handler) );
+}
+
+inline options & options::add(
+    std::initializer_list< std::string_view > names,
+    std::size_t arity,
+    std::string_view help,
+    std::function< void( args & ) > handler
+) {
+    option opt;
+    opt.names.assign( names.begin(), names.end() );
+    opt.arity = arity;
+    opt.help = help;
+    opt.handler = std::move(handler);
+    _options.push_back( std::move(opt) );
+    _compiled = false;
+    return *this;
+}
+
+inline bool options::parse_one( args & args ) {
+    auto arg = args.try_peek();
+    if( !arg )
+        return false;
+
+    std::size_t index = find( *arg );
+    if( index == npos )
+        return false;
+
+    const option & opt = _options[index];
+    if( detail::check_arity( args, opt.arity ) )
+        opt.handler( args );
+    return true;
+}
+
+inline void options::parse( args & args ) {
+    detail::parse_options( args, [&]() { return parse_one( args ); } );
+}
+
+inline void options::help( std::ostream & os ) const {
+    std::vector< std::string > columns;
+    std::size_t width = 0;
+    for( const option & opt : _options ) {
+        std::string column;
+        for( const std::string & name : opt.names ) {
+            if( !column.empty() )
+                column += ", ";
+            column += name;
+        }
+        if( column.size() > width )
+            width = column.size();
+        columns.push_back( std::move(column) );
+    }
+
+    for( std::size_t i = 0; i < _options.size(); i++ ) {
+        os << "  " << columns[i];
+        if( !_options[i].help.empty() )
+            os << std::string( width - columns[i].size() + 2, ' ' )
+                << _options[i].help;
+        os << '\n';
+    }
+}
+
+inline std::size_t options::find( std::string_view name ) {
+    if( !_compiled )
+        compile();
+    std::size_t slot = detail::perfect_hash_slot( detail::hash( name ),
+        _seeds.data(), _seeds.size(), _slots.size() );
+    std::size_t index = _slots[slot];
+    if( index == npos )
+        return npos;
+    auto [opt, name_index] = _names[index];
+    if( _options[opt].names[name_index] != name )
+        return npos;
+    return opt;
+}
+
+inline void options::compile() {
+    std::vector< std::pair< std::size_t, std::size_t > > names;
+    std::vector< std::uint64_t > hashes;
+    for( std::size_t i = 0; i < _options.size(); i++ )
+        for( std::size_t j = 0; j < _options[i].names.size(); j++ ) {
+            const std::string & name = _options[i].names[j];
+            /* Repeated name; the first option wins. */
+            bool repeated = false;
+            for( const auto & [opt, name_index] : names )
+                if( _options[opt].names[name_index] == name )
+                    repeated = true;
+            if( repeated )
+                continue;
+            names.emplace_back( i, j );
+            hashes.push_back( detail::hash( name ) );
+        }
+
+    std::vector< std::uint64_t > seeds( detail::hash_buckets( names.size() ) );
+    std::vector< std::size_t > slots( detail::hash_slots( names.size() ) );
+    std::vector< std::size_t > scratch( seeds.size() + names.size() );
+    if( !detail::build_perfect_hash( hashes.data(), names.size(),
+            seeds.data(), seeds.size(), slots.data(), slots.size(),
+            scratch.data() ) )
+        throw std::logic_error( "Could not build the perfect hash." );
+
+    _names = std::move( names );
+    _seeds = std::move( seeds );
+    _slots = std::move( slots );
+    _compiled = true;
+}
+
+template< const auto & Specs >
+constexpr std::size_t static_options< Specs >::find( std::string_view name ) {
+    std::size_t slot = detail::perfect_hash_slot( detail::hash( name ),
+        _table.seeds.data(), buckets, slots );
+    std::size_t index = _table.table[slot];
+    if( index == detail::npos || _table.names[index] != name )
+        return detail::npos;
+    return _table.option[index];
+}
+
+template< const auto & Specs >
+bool static_options< Specs >::parse_one( args & args, context_type & context ) {
+    auto arg = args.try_peek();
+    if( !arg )
+        return false;
+
+    std::size_t index = find( *arg );
+    if( index == detail::npos )
+        return false;
+
+    if( detail::check_arity( args, Specs[index].arity ) )
+        Specs[index].handler( args, context );
+    return true;
+}
+
+template< const auto & Specs >
+void static_options< Specs >::parse( args & args, context_type & context ) {
+    detail::parse_options( args, [&]() { return parse_one( args, context ); } );
+}
+
+template< const auto & Specs >
+constexpr std::string_view static_options< Specs >::help_text() {
+    return std::string_view( _help.data(), _help.size() );
+}
+
+template< const auto & Specs >
+void static_options< Specs >::help( std::ostream & os ) {
+    os << help_text();
+}
+
+} // namespace cmdline
+
+#endif // CMDLINE_OPTIONS_H
@@ -0,0 +1,263 @@
+#ifndef CMDLINE_STREAM_H
+#define CMDLINE_STREAM_H
+
+/* Class that reads arguments incrementally from a file descriptor
+ * or an input stream, for pipelines like
+ *  find -print0 | tool --files-from -
+ *
+ * The arguments are separated by a delimiter (usually '\0' or '\n')
+ * and are read in large chunks as they are requested,
+ * so the first argument can be processed before the producer finishes
+ * and the memory used depends only on the longest argument,
+ * not on the size of the input.
+ *
+ * Unlike cmdline::args, there is no size():
+ * the number of remaining arguments is only known at the end of the input.
+ * Use empty() instead.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <istream>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "args.hpp"
+
+namespace cmdline {
+
+    class arg_stream {
+        std::vector< char > _buffer;
+        std::size_t _begin;     // First unread byte.
+        std::size_t _end;       // One past the last byte read.
+        std::size_t _scanned;   // Bytes of [_begin, _end) with no delimiter.
+        std::size_t _next;      // Length of the next argument, or npos.
+        bool _eof;
+        char _delimiter;
+
+        int _fd;
+        std::istream * _stream;
+
+        static constexpr std::size_t npos = -1;
+
+    public:
+        /* Reads the arguments from the given file descriptor.
+         * The descriptor is not closed.
+         * Only available on POSIX systems.
+         */
+#ifdef CMDLINE_POSIX
+        explicit arg_stream(
+            int fd,
+            char delimiter = '\0',
+            std::size_t buffer_size = 1 << 16
+        );
+#endif
+
+        /* Reads the arguments from the given stream.
+         * Note that std::istream::read blocks until the buffer is full,
+         * so arguments are only available in chunks of buffer_size bytes.
+         */
+        explicit arg_stream(
+            std::istream & stream,
+            char delimiter = '\0',
+            std::size_t buffer_size = 1 << 16
+        );
+
+        /* Returns true if there are no arguments left.
+         * Blocks until the next argument is completely read,
+         * or the end of the input is found.
+         *
+         * If the input does not end with a delimiter,
+         * the bytes after the last delimiter form the last argument.
+         */
+        bool empty();
+
+        /* Take a look into the next argument.
+         * If there is no arguments left, throws std::out_of_range.
+         *
+         * The returned view points into the internal buffer,
+         * and is valid only until the next call to a non-const member.
+         */
+        std::string_view peek();
+
+        /* Discards the next argument.
+         * If there is no arguments left, throws std::out_of_range.
+         */
+        void shift();
+
+        /* Obtains the next argument and discards it.
+         * The returned view is valid until the next call to a member.
+         * If there is no arguments left, throws std::out_of_range.
+         */
+        std::string_view next();
+
+        /* Non-throwing versions of peek and next. */
+        result< std::string_view > try_peek();
+        result< std::string_view > try_next();
+
+        /* Reads up to 'size' arguments into a cmdline::args,
+         * so that they can be parsed with operator>>, options, etc.
+         * The arguments are copied; the returned object
+         * does not depend on this one.
+         */
+        args batch( std::size_t size );
+
+    private:
+        /* Locates the next argument, reading more input if needed.
+         * Afterwards, either _next != npos or the input is exhausted. */
+        void fill();
+
+        /* Reads more input into the buffer; sets _eof at the end. */
+        void read_more();
+    };
+
+// Class implementation
+
+#ifdef CMDLINE_POSIX
+inline arg_stream::arg_stream( int fd, char delimiter, std::size_t buffer_size ) :
+    _buffer( buffer_size > 0 ? buffer_size : 1 ),
+    _begin( 0 ),
+    _end( 0 ),
+    _scanned( 0 ),
+    _next( npos ),
+    _eof( false ),
+    _delimiter( delimiter ),
+    _fd( fd ),
+    _stream( nullptr )
+{}
+#endif
+
+inline arg_stream::arg_stream(
+    std::istream & stream,
+    char delimiter,
+    std::size_t buffer_size
+) :
+    _buffer( buffer_size > 0 ? buffer_size : 1 ),
+    _begin( 0 ),
+    _end( 0 ),
+    _scanned( 0 ),
+    _next( npos ),
+    _eof( false ),
+    _delimiter( delimiter ),
+    _fd( -1 ),
+    _stream( &stream )
+{}
+
+inline bool arg_stream::empty() {
+    fill();
+    return _next == npos;
+}
+
+inline std::string_view arg_stream::peek() {
+    auto ret = try_peek();
+    if( !ret )
+        throw std::out_of_range( "No argument left to peek." );
+    return *ret;
+}
+
+inline void arg_stream::shift() {
+    if( !try_next() )
+        throw std::out_of_range( "No arguments left to shift." );
+}
+
+inline std::string_view arg_stream::next() {
+    auto ret = try_next();
+    if( !ret )
+        throw std::out_of_range( "No argument left to peek." );
+    return *ret;
+}
+
+inline result< std::string_view > arg_stream::try_peek() {
+    fill();
+    if( _next == npos )
+        return error_code::no_arguments_left;
+    return std::string_view( _buffer.data() + _begin, _next );
+}
+
+inline result< std::string_view > arg_stream::try_next() {
+    auto ret = try_peek();
+    if( ret ) {
+        /* Skip the delimiter too, unless this is an unterminated last argument. */
+        _begin += _next;
+        if( _begin < _end )
+            _begin++;
+        _scanned = 0;
+        _next = npos;
+    }
+    return ret;
+}
+
+inline args arg_stream::batch( std::size_t size ) {
+    args ret;
+    for( ; size > 0; size-- ) {
+        auto arg = try_next();
+        if( !arg )
+            break;
+        ret.emplace_back( *arg );
+    }
+    return ret;
+}
+
+inline void arg_stream::fill() {
+    while( _next == npos ) {
+        const char * first = _buffer.data() + _begin + _scanned;
+        const char * found = (const char *)
+            std::memchr( first, _delimiter, _end - _begin - _scanned );
+        if( found ) {
+            _next = found - (_buffer.data() + _begin);
+            return;
+        }
+        _scanned = _end - _begin;
+
+        if( _eof ) {
+            if( _begin < _end )
+                _next = _end - _begin;
+            return;
+        }
+        read_more();
+    }
+}
+
+inline void arg_stream::read_more() {
+    /* Move the partial argument to the beginning of the buffer,
+     * and grow the buffer only if the argument fills all of it. */
+    if( _begin > 0 ) {
+        std::memmove( _buffer.data(), _buffer.data() + _begin, _end - _begin );
+        _end -= _begin;
+        _begin = 0;
+    }
+    if( _end == _buffer.size() )
+        _buffer.resize( 2 * _buffer.size() );
+
+    char * target = _buffer.data() + _end;
+    std::size_t room = _buffer.size() - _end;
+#ifdef CMDLINE_POSIX
+    if( _fd >= 0 ) {
+        ssize_t count;
+        do
+            count = ::read( _fd, target, room );
+        while( count < 0 && errno == EINTR );
+        if( count < 0 )
+            throw std::system_error( errno, std::generic_category(),
+                "Could not read arguments" );
+        if( count == 0 )
+            _eof = true;
+        _end += count;
+        return;
+    }
+#endif
+    _stream->read( target, room );
+    _end += _stream->gcount();
+    if( !*_stream ) {
+        if( _stream->bad() )
+            throw std::system_error( std::make_error_code( std::errc::io_error ),
+                "Could not read arguments" );
+        _eof = true;
+    }
+}
+
+} // namespace cmdline
+
+#endif // CMDLINE_STREAM_H